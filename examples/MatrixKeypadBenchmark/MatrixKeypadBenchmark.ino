@@ -0,0 +1,187 @@
+/**
+ * Matrix Keypad
+ *
+ * This example measures the cycles the library takes to scan keypads of several sizes on the board, the scans per second and the latency from a key press to MatrixKeypad_getKey.
+ * Don't connect a keypad: the scan of an idle keypad costs the same, and the latency run presses a key by driving the pin of its column LOW. Pins 0 and 1 (serial) aren't used.
+ * The sizes that need more pins than the board has, or more rows and columns than MATRIXKEYPAD_MAX_ROWS and MATRIXKEYPAD_MAX_COLS, are skipped.
+ * The cycles are read from the Timer1 on AVR, the DWT cycle counter on Cortex-M3/M4/M7 and CCOUNT on ESP32. The other boards use micros() and F_CPU.
+ * The results change with the compile options of MatrixKeypad_config.h, for example MATRIXKEYPAD_FAST_IO on AVR. Leave MATRIXKEYPAD_PROGMEM disabled, the mappings are in the SRAM.
+ * The host benchmark of extras/host measures the same sizes on a simulated matrix.
+ *
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ */
+
+#include "MatrixKeypad.h"
+#include <stdint.h>
+
+#if defined(__AVR__)
+	/* Timer1 counts the cpu cycles (no prescaler). A frame must take less than 65536 cycles */
+	#define CYCLES_BEGIN() do { TCCR1A = 0; TCCR1B = _BV(CS10); } while(0)
+	#define CYCLES() ((uint32_t)TCNT1)
+	#define CYCLES_MASK 0xFFFFUL
+	#define CYCLES_ATOMIC 1
+#elif defined(ESP32)
+	#define CYCLES_BEGIN() do { } while(0)
+	#define CYCLES() ((uint32_t)ESP.getCycleCount())
+	#define CYCLES_MASK 0xFFFFFFFFUL
+	#define CYCLES_ATOMIC 1
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+	#define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+	#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+	#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+	#define CYCLES_BEGIN() do { DEMCR |= 1UL << 24; DWT_CYCCNT = 0; DWT_CTRL |= 1; } while(0) /* TRCENA, then CYCCNTENA */
+	#define CYCLES() DWT_CYCCNT
+	#define CYCLES_MASK 0xFFFFFFFFUL
+	#define CYCLES_ATOMIC 1
+#else
+	#define CYCLES_BEGIN() do { } while(0)
+	#define CYCLES() ((uint32_t)(micros() * (F_CPU / 1000000UL)))
+	#define CYCLES_MASK 0xFFFFFFFFUL
+	#define CYCLES_ATOMIC 0 //micros() needs the interrupts
+#endif
+
+#define FRAMES 100 //frames measured for each size
+#define SCANS_US 100000UL //duration of the scans per second run, in microseconds
+#define INTERVAL_US 5000UL //scan interval of the latency run, in microseconds
+#define PRESSES 20 //key presses of the latency run
+#define TIMEOUT_US 1000000UL //a press that isn't read in this time is missed
+
+const uint8_t sizes[][2] = {{3, 4}, {4, 3}, {4, 4}, {6, 6}, {8, 8}, {12, 12}, {16, 16}}; //rows and columns
+uint8_t pins[MATRIXKEYPAD_MAX_ROWS + MATRIXKEYPAD_MAX_COLS];
+char keymap[MATRIXKEYPAD_MAX_ROWS * MATRIXKEYPAD_MAX_COLS];
+MatrixKeypad_t keypad;
+
+//Scans the keypad as fast as possible for SCANS_US and returns the scans per second
+uint32_t scansPerSecond() {
+
+	uint32_t start, scans;
+
+	scans = 0;
+	start = micros();
+	while(micros() - start < SCANS_US){
+		MatrixKeypad_scan(&keypad);
+		scans++;
+	}
+
+	return scans * (1000000UL / SCANS_US);
+}
+
+//Presses a key at a random time, scanning each INTERVAL_US, and returns the microseconds until MatrixKeypad_getKey reads it
+uint32_t pressLatency(uint8_t colPin) {
+
+	uint32_t now, scanned, pressed, pressAt;
+	uint8_t i;
+
+	MatrixKeypad_flush(&keypad);
+	pressed = 0;
+	scanned = micros();
+	pressAt = scanned + random(INTERVAL_US);
+	while(1){
+		now = micros();
+		if(pressed == 0 && (int32_t)(now - pressAt) >= 0) {
+			pinMode(colPin, OUTPUT); //the column reads LOW on every row, as if a key was pressed
+			digitalWrite(colPin, LOW);
+			pressed = 1;
+			pressAt = micros();
+		}
+		if(now - scanned >= INTERVAL_US) {
+			scanned += INTERVAL_US;
+			MatrixKeypad_scan(&keypad);
+		}
+		if(pressed != 0 && (MatrixKeypad_getKey(&keypad) != '\0' || micros() - pressAt > TIMEOUT_US)) {
+			break;
+		}
+	}
+	now = micros() - pressAt;
+
+	pinMode(colPin, INPUT_PULLUP); //releases the key
+	for(i = 0; i < 16; i++){ //enough frames to debounce the release
+		MatrixKeypad_scan(&keypad);
+		delayMicroseconds(INTERVAL_US / 8);
+	}
+	MatrixKeypad_flush(&keypad);
+
+	return now;
+}
+
+void setup() {
+
+	uint8_t i, rown, coln, press, missed;
+	uint32_t start, cycles, total, worst, latency;
+	uint16_t frame, key;
+
+	Serial.begin(9600);
+	for(i = 0; i < sizeof(pins); i++){
+		pins[i] = 2 + i;
+	}
+	for(key = 0; key < sizeof(keymap); key++){
+		keymap[key] = 'A' + (key % 26);
+	}
+	CYCLES_BEGIN();
+
+	Serial.println(F("size\tcyc avg\tcyc max\tscans/s\tlat avg\tlat max\tmissed")); //cycles per frame, latency in microseconds
+	for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+		rown = sizes[i][0];
+		coln = sizes[i][1];
+		if(2 + rown + coln > NUM_DIGITAL_PINS || rown > MATRIXKEYPAD_MAX_ROWS || coln > MATRIXKEYPAD_MAX_COLS) {
+			continue; //the board doesn't have enough pins
+		}
+		if(MatrixKeypad_init(&keypad, keymap, pins, pins + rown, rown, coln) == NULL) {
+			continue;
+		}
+
+		total = 0;
+		worst = 0;
+		for(frame = 0; frame < FRAMES; frame++){
+#if CYCLES_ATOMIC
+			noInterrupts(); //the millis interrupt would be counted
+#endif
+			start = CYCLES();
+			MatrixKeypad_scan(&keypad);
+			cycles = (CYCLES() - start) & CYCLES_MASK;
+#if CYCLES_ATOMIC
+			interrupts();
+#endif
+			total += cycles;
+			if(cycles > worst) {
+				worst = cycles;
+			}
+		}
+
+		Serial.print(rown);
+		Serial.print('x');
+		Serial.print(coln);
+		Serial.print('\t');
+		Serial.print(total / FRAMES);
+		Serial.print('\t');
+		Serial.print(worst);
+		Serial.print('\t');
+		Serial.print(scansPerSecond());
+
+		total = 0;
+		worst = 0;
+		missed = 0;
+		for(press = 0; press < PRESSES; press++){
+			latency = pressLatency(pins[rown + coln - 1]); //the last column
+			if(latency > TIMEOUT_US) {
+				missed++;
+				continue;
+			}
+			total += latency;
+			if(latency > worst) {
+				worst = latency;
+			}
+		}
+
+		Serial.print('\t');
+		Serial.print(missed < PRESSES ? total / (PRESSES - missed) : 0);
+		Serial.print('\t');
+		Serial.print(worst);
+		Serial.print('\t');
+		Serial.println(missed);
+	}
+}
+
+void loop() {
+}
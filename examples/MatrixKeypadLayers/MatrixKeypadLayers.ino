@@ -0,0 +1,56 @@
+/**
+ * Matrix Keypad
+ * 
+ * This example shows how to keep the mappings in the flash memory and switch between two key mappings (layers).
+ * The '*' key toggles between the numbers and the letters.
+ * Set MATRIXKEYPAD_PROGMEM to 1 in MatrixKeypad_config.h, otherwise the AVR cores read the mappings from the SRAM.
+ * 
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ */
+
+#include "MatrixKeypad.h"
+#include <stdint.h>
+
+const uint8_t rown = 4; //4 rows
+const uint8_t coln = 3; //3 columns
+const uint8_t rowPins[rown] PROGMEM = {10, 9, 8, 7}; //frist row is connect to pin 10, second to 9...
+const uint8_t colPins[coln] PROGMEM = {6, 5, 4}; //frist column is connect to pin 6, second to 5...
+const char layers[2][rown][coln] PROGMEM = 
+  {{{'1','2','3'}, //first layer, the numbers
+    {'4','5','6'},
+    {'7','8','9'},
+    {'*','0','#'}},
+   {{'A','B','C'}, //second layer, the letters
+    {'D','E','F'},
+    {'G','H','I'},
+    {'*','J','K'}}};
+MatrixKeypad_t keypad; //the keypad is a global variable, so it doesn't use the heap
+
+uint8_t layer = 0;
+char key;
+
+void setup() {
+
+	Serial.begin(9600);
+
+	MatrixKeypad_init(&keypad, (const char*)layers[layer], rowPins, colPins, rown, coln); //initializes the keypad object
+
+}
+
+void loop() {
+
+	MatrixKeypad_scan(&keypad); //scans for a key press event
+	if(MatrixKeypad_hasKey(&keypad)){ //if a key was pressed
+		key = MatrixKeypad_getKey(&keypad); //get the key
+		if(key == '*') {
+			layer = !layer;
+			MatrixKeypad_setKeymap(&keypad, (const char*)layers[layer]); //switches the layer, the keypad keeps its pins and state
+		}
+		else {
+			Serial.print(key); //prints the pressed key to the serial output
+		}
+	}
+	
+	delay(20); //do something
+}
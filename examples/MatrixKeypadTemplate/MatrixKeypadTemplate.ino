@@ -0,0 +1,40 @@
+/**
+ * Matrix Keypad
+ * 
+ * This example shows how to use the compile time specialized keypad (C++ template) to perform a non blocking scanning of a generic keypad.
+ * The pins are template parameters, so the scan is unrolled and uses less flash and cpu time than the C functions.
+ * 
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ */
+
+#include "MatrixKeypad.hpp"
+#include <stdint.h>
+
+const char keymap[4][3] = 
+  {{'1','2','3'}, //key of the frist row frist column is '1', frist row second column column is '2'
+   {'4','5','6'}, //key of the second row frist column is '4', second row second column column is '5'
+   {'7','8','9'},
+   {'*','0','#'}};
+MatrixKeypad<4, 3, 10, 9, 8, 7, 6, 5, 4> keypad((const char*)keymap); //4 rows connected to the pins 10, 9, 8, 7 and 3 columns connected to the pins 6, 5, 4
+
+char key;
+
+void setup() {
+
+	Serial.begin(9600);
+
+	keypad.begin(); //configures the pins
+
+}
+
+void loop() {
+
+	keypad.scan(); //scans for a key press event
+	if(keypad.hasKey()){ //if a key was pressed
+		key = keypad.getKey(); //get the key
+		Serial.print(key); //prints the pressed key to the serial output
+	}
+	
+	delay(20); //do something
+}
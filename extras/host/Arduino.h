@@ -0,0 +1,79 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file Arduino.h
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Host HAL. Declares the subset of the Arduino core used by the library, so src/MatrixKeypad.c builds on a desktop compiler.
+ * The functions are implemented by the simulated matrix of MatrixKeypad_sim.c. Put this directory in the include path (-Iextras/host)
+ * and the library picks this header instead of the one of the Arduino core.
+ *
+ * The host has no AVR or ESP32 specific hardware, so the options that depend on it (MATRIXKEYPAD_FAST_IO, the timer interrupt, the sleep modes,
+ * the FreeRTOS task) fall back to their portable paths. Every pin has an external interrupt.
+ */
+#ifndef MATRIXKEYPAD_HOST_ARDUINO_H
+#define MATRIXKEYPAD_HOST_ARDUINO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#define LOW 0
+#define HIGH 1
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(pin) ((int)(pin))
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+
+void pinMode (uint8_t pin, uint8_t mode);
+void digitalWrite (uint8_t pin, uint8_t level);
+int digitalRead (uint8_t pin);
+
+unsigned long millis (void);
+unsigned long micros (void);
+void delay (unsigned long ms);
+void delayMicroseconds (unsigned int us);
+void yield (void);
+
+void noInterrupts (void);
+void interrupts (void);
+void attachInterrupt (uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt (uint8_t interrupt);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,214 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_benchmark.c
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Scan benchmark on the simulated matrix, for keypads from 3x4 to 16x16. Build and run it from the root of the repository:
+ *
+ *     cc -O2 -Iextras/host -Isrc -DMATRIXKEYPAD_MAX_ROWS=16 -DMATRIXKEYPAD_MAX_COLS=16 src/MatrixKeypad.c extras/host/MatrixKeypad_sim.c extras/host/MatrixKeypad_benchmark.c -o benchmark
+ *     ./benchmark
+ *
+ * Add the compile options to be measured to the command, for example "-DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_EARLY_EXIT=1".
+ *
+ * For each size it reports:
+ *  - the host scans per second and the host time (and cycles, on x86) per frame, to compare two revisions of the library;
+ *  - the pin accesses and the target time per frame of an idle keypad and of a keypad with a key pressed, from the pin access costs of the simulation;
+ *  - the average and the worst latency from a key press to MatrixKeypad_getKey, scanning each 5ms with 2ms of contact bounce.
+ *
+ * The cycles per frame, the scans per second and the press to key latency on the target are measured by the MatrixKeypadBenchmark example sketch.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include "MatrixKeypad.h"
+#include "MatrixKeypad_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define MATRIXKEYPAD_BENCH_CYCLES 1
+#else
+	#define MATRIXKEYPAD_BENCH_CYCLES 0
+#endif
+
+#if MATRIXKEYPAD_MAX_ROWS < 16 || MATRIXKEYPAD_MAX_COLS < 16
+	#error "The benchmark measures keypads up to 16x16, build it with -DMATRIXKEYPAD_MAX_ROWS=16 -DMATRIXKEYPAD_MAX_COLS=16"
+#endif
+
+#define MATRIXKEYPAD_BENCH_WALL_NS 100000000 /* each throughput run lasts 100ms of host time */
+#define MATRIXKEYPAD_BENCH_INTERVAL 5000 /* scan interval of the latency run, in microseconds */
+#define MATRIXKEYPAD_BENCH_BOUNCE 2000 /* contact bounce of the latency run, in microseconds */
+#define MATRIXKEYPAD_BENCH_PRESSES 50 /* key presses of the latency run */
+
+typedef struct {
+	uint8_t rown;
+	uint8_t coln;
+} MatrixKeypadBench_size_t;
+
+static const MatrixKeypadBench_size_t MatrixKeypadBench_sizes[] = {{3, 4}, {4, 4}, {6, 6}, {8, 8}, {16, 16}};
+
+static uint8_t MatrixKeypadBench_rowPins[16];
+static uint8_t MatrixKeypadBench_colPins[16];
+static char MatrixKeypadBench_keymap[16 * 16];
+
+static uint64_t MatrixKeypadBench_wall (void){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Scans the keypad for MATRIXKEYPAD_BENCH_WALL_NS of host time */
+static void MatrixKeypadBench_throughput (MatrixKeypad_t *keypad){
+
+	uint64_t start, elapsed;
+	uint32_t scans = 0, i;
+#if MATRIXKEYPAD_BENCH_CYCLES
+	uint64_t cycles = __rdtsc();
+#endif
+
+	start = MatrixKeypadBench_wall();
+	do {
+		for(i = 0; i < 256; i++){
+			MatrixKeypad_scan(keypad);
+		}
+		scans += 256;
+		elapsed = MatrixKeypadBench_wall() - start;
+	} while(elapsed < MATRIXKEYPAD_BENCH_WALL_NS);
+#if MATRIXKEYPAD_BENCH_CYCLES
+	cycles = __rdtsc() - cycles;
+#endif
+
+	printf("%10.0f %9.1f", scans * 1e9 / elapsed, (double)elapsed / scans);
+#if MATRIXKEYPAD_BENCH_CYCLES
+	printf(" %9.0f", (double)cycles / scans);
+#else
+	printf(" %9s", "-");
+#endif
+}
+
+/* Prints the pin accesses and the target time of one frame */
+static void MatrixKeypadBench_frame (MatrixKeypad_t *keypad){
+
+	uint32_t writes = MatrixKeypadSim_getWrites(), reads = MatrixKeypadSim_getReads();
+	uint64_t start = MatrixKeypadSim_now();
+
+	MatrixKeypad_scan(keypad);
+	printf(" %4u/%-4u %8.1f", (unsigned)(MatrixKeypadSim_getWrites() - writes), (unsigned)(MatrixKeypadSim_getReads() - reads), (MatrixKeypadSim_now() - start) / 1000.0);
+}
+
+/* Presses random keys at random times and measures the time until MatrixKeypad_getKey returns them */
+static void MatrixKeypadBench_latency (MatrixKeypad_t *keypad, const MatrixKeypadBench_size_t *size){
+
+	uint32_t i, latency, total = 0, worst = 0, missed = 0;
+	uint64_t pressed, start;
+	uint8_t row, col;
+
+	MatrixKeypadSim_setBounce(MATRIXKEYPAD_BENCH_BOUNCE);
+	srand(size->rown * 16 + size->coln);
+
+	for(i = 0; i < MATRIXKEYPAD_BENCH_PRESSES; i++){
+		row = rand() % size->rown;
+		col = rand() % size->coln;
+		MatrixKeypadSim_advance(rand() % MATRIXKEYPAD_BENCH_INTERVAL); /* the press happens at any phase of the scan interval */
+		MatrixKeypadSim_press(MatrixKeypadBench_rowPins[row], MatrixKeypadBench_colPins[col]);
+		pressed = MatrixKeypadSim_now();
+
+		while(MatrixKeypadSim_now() - pressed < 100000000) { /* gives up after 100ms */
+			start = MatrixKeypadSim_now();
+			MatrixKeypad_scan(keypad);
+			if(MatrixKeypad_getKey(keypad) != '\0') {
+				break;
+			}
+			if(MatrixKeypadSim_now() - start < MATRIXKEYPAD_BENCH_INTERVAL * 1000) {
+				MatrixKeypadSim_advance(MATRIXKEYPAD_BENCH_INTERVAL - (uint32_t)((MatrixKeypadSim_now() - start) / 1000));
+			}
+		}
+		latency = (uint32_t)((MatrixKeypadSim_now() - pressed) / 1000);
+		if(latency >= 100000) {
+			missed++;
+		}
+		total += latency;
+		if(latency > worst) {
+			worst = latency;
+		}
+
+		/* releases the key and scans until the release is seen, so the next press is a new one */
+		MatrixKeypadSim_release(MatrixKeypadBench_rowPins[row], MatrixKeypadBench_colPins[col]);
+		for(start = MatrixKeypadSim_now(); MatrixKeypadSim_now() - start < 50000000;){
+			MatrixKeypad_scan(keypad);
+			MatrixKeypadSim_advance(MATRIXKEYPAD_BENCH_INTERVAL);
+		}
+		MatrixKeypad_flush(keypad); /* drops the keys read while the contact bounced */
+	}
+
+	MatrixKeypadSim_setBounce(0);
+	printf(" %8.0f %8u %6u\n", (double)total / MATRIXKEYPAD_BENCH_PRESSES, (unsigned)worst, (unsigned)missed);
+}
+
+int main (void){
+
+	MatrixKeypad_t keypad;
+	MatrixKeypad_layout_t layout; /* MatrixKeypad_initLayout works with and without MATRIXKEYPAD_COMPACT */
+	const MatrixKeypadBench_size_t *size;
+	uint16_t i;
+	uint8_t pin;
+
+	for(i = 0; i < sizeof(MatrixKeypadBench_keymap); i++){
+		MatrixKeypadBench_keymap[i] = (char)(i % 254 + 1); /* '\0' isn't a valid key */
+	}
+
+	printf("%-6s %10s %9s %9s %9s %8s %9s %8s %8s %8s %6s\n", "size", "scans/s", "host ns", "host cyc",
+		"idle w/r", "idle us", "key w/r", "key us", "lat avg", "lat max", "missed");
+
+	for(i = 0; i < sizeof(MatrixKeypadBench_sizes) / sizeof(MatrixKeypadBench_sizes[0]); i++){
+		size = &MatrixKeypadBench_sizes[i];
+		MatrixKeypadSim_reset();
+		for(pin = 0; pin < 16; pin++){
+			MatrixKeypadBench_rowPins[pin] = pin;
+			MatrixKeypadBench_colPins[pin] = 16 + pin;
+		}
+		layout.rowPins = MatrixKeypadBench_rowPins;
+		layout.colPins = MatrixKeypadBench_colPins;
+		layout.keyMap = MatrixKeypadBench_keymap;
+		layout.rown = size->rown;
+		layout.coln = size->coln;
+		if(MatrixKeypad_initLayout(&keypad, &layout) == NULL) {
+			printf("%2ux%-3u couldn't be initialized\n", size->rown, size->coln);
+			continue;
+		}
+
+		printf("%2ux%-3u", size->rown, size->coln);
+		MatrixKeypadBench_throughput(&keypad);
+		MatrixKeypadBench_frame(&keypad);
+		MatrixKeypadSim_press(MatrixKeypadBench_rowPins[size->rown - 1], MatrixKeypadBench_colPins[size->coln - 1]); /* the last key, the worst case of the early exit */
+		MatrixKeypadBench_frame(&keypad);
+		MatrixKeypadSim_release(MatrixKeypadBench_rowPins[size->rown - 1], MatrixKeypadBench_colPins[size->coln - 1]);
+		MatrixKeypad_scan(&keypad);
+		MatrixKeypad_flush(&keypad);
+		MatrixKeypadBench_latency(&keypad, size);
+	}
+
+	return 0;
+}
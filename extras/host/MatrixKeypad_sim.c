@@ -0,0 +1,302 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_sim.c
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Simulated keypad matrix and the implementation of the host HAL.
+ *
+ */
+#include "Arduino.h"
+#include "MatrixKeypad_sim.h"
+#include <stddef.h>
+
+#define MATRIXKEYPAD_SIM_BOUNCE_STEP 100000 /* the contact of a bouncing key changes at most once each 100us */
+
+typedef struct {
+	uint8_t pressed; /* state of the key after the bounce */
+	uint64_t since; /* time of the last press or release */
+} MatrixKeypadSim_key_t;
+
+static uint8_t MatrixKeypadSim_mode[MATRIXKEYPAD_SIM_PINS];
+static uint8_t MatrixKeypadSim_level[MATRIXKEYPAD_SIM_PINS]; /* level driven by the output pins */
+static uint64_t MatrixKeypadSim_changed[MATRIXKEYPAD_SIM_PINS]; /* time of the last level change of the output pins */
+static MatrixKeypadSim_key_t MatrixKeypadSim_keys[MATRIXKEYPAD_SIM_PINS][MATRIXKEYPAD_SIM_PINS]; /* indexed by [row pin][column pin] */
+
+static void (*MatrixKeypadSim_isr[MATRIXKEYPAD_SIM_PINS])(void);
+static uint8_t MatrixKeypadSim_isrLevel[MATRIXKEYPAD_SIM_PINS]; /* last level seen by the interrupt of each pin */
+static uint8_t MatrixKeypadSim_inISR;
+
+static uint64_t MatrixKeypadSim_clock; /* virtual clock in nanoseconds */
+static uint32_t MatrixKeypadSim_writes, MatrixKeypadSim_reads;
+
+static uint64_t MatrixKeypadSim_bounce = 0;
+static uint64_t MatrixKeypadSim_settle = 0;
+static uint32_t MatrixKeypadSim_writeCost = 3000; /* about 50 cycles at 16MHz */
+static uint32_t MatrixKeypadSim_readCost = 3000;
+static uint8_t MatrixKeypadSim_diodes = 1;
+
+/* Returns 1 if the contact of a key is closed. While the key bounces, the contact opens and closes in a pseudo random pattern */
+static uint8_t MatrixKeypadSim_contact (uint8_t row, uint8_t col){
+
+	MatrixKeypadSim_key_t *key = &MatrixKeypadSim_keys[row][col];
+	uint64_t elapsed = MatrixKeypadSim_clock - key->since;
+	uint32_t hash;
+
+	if(key->since == 0 || elapsed >= MatrixKeypadSim_bounce) {
+		return key->pressed;
+	}
+
+	hash = (uint32_t)(row * 64 + col) * 2654435761u ^ (uint32_t)(elapsed / MATRIXKEYPAD_SIM_BOUNCE_STEP) * 40503u;
+	return (hash >> 13) & 1;
+}
+
+/* Returns 1 if the row pin pulls its keys LOW. The line follows a change of the output only after the settle time */
+static uint8_t MatrixKeypadSim_rowLow (uint8_t row){
+
+	uint8_t settled;
+
+	if(MatrixKeypadSim_mode[row] != OUTPUT) {
+		return 0;
+	}
+
+	settled = MatrixKeypadSim_clock - MatrixKeypadSim_changed[row] >= MatrixKeypadSim_settle;
+	return MatrixKeypadSim_level[row] == LOW ? settled : !settled;
+}
+
+/* Returns 1 if a path of closed contacts connects the row and the column. Without diodes, the path can go through two other keys */
+static uint8_t MatrixKeypadSim_connected (uint8_t row, uint8_t col){
+
+	uint8_t r, c;
+
+	if(MatrixKeypadSim_contact(row, col)) {
+		return 1;
+	}
+	if(MatrixKeypadSim_diodes) {
+		return 0;
+	}
+
+	for(c = 0; c < MATRIXKEYPAD_SIM_PINS; c++){
+		if(c == col || !MatrixKeypadSim_contact(row, c)) {
+			continue;
+		}
+		for(r = 0; r < MATRIXKEYPAD_SIM_PINS; r++){
+			if(r != row && MatrixKeypadSim_contact(r, c) && MatrixKeypadSim_contact(r, col)) {
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Returns the level of a pin at the current time */
+static uint8_t MatrixKeypadSim_pinLevel (uint8_t pin){
+
+	uint8_t row;
+
+	if(MatrixKeypadSim_mode[pin] == OUTPUT) {
+		return MatrixKeypadSim_level[pin];
+	}
+
+	for(row = 0; row < MATRIXKEYPAD_SIM_PINS; row++){
+		if(MatrixKeypadSim_rowLow(row) && MatrixKeypadSim_connected(row, pin)) {
+			return LOW;
+		}
+	}
+
+	return HIGH; /* pulled up */
+}
+
+/* Calls the interrupt of each pin that had a falling edge since the last check */
+static void MatrixKeypadSim_checkInterrupts (void){
+
+	uint8_t pin, level;
+
+	if(MatrixKeypadSim_inISR) {
+		return;
+	}
+
+	MatrixKeypadSim_inISR = 1;
+	for(pin = 0; pin < MATRIXKEYPAD_SIM_PINS; pin++){
+		if(MatrixKeypadSim_isr[pin] == NULL) {
+			continue;
+		}
+		level = MatrixKeypadSim_pinLevel(pin);
+		if(level == LOW && MatrixKeypadSim_isrLevel[pin] == HIGH) {
+			MatrixKeypadSim_isr[pin]();
+		}
+		MatrixKeypadSim_isrLevel[pin] = level;
+	}
+	MatrixKeypadSim_inISR = 0;
+}
+
+void MatrixKeypadSim_reset (void){
+
+	uint8_t i, j;
+
+	for(i = 0; i < MATRIXKEYPAD_SIM_PINS; i++){
+		MatrixKeypadSim_mode[i] = INPUT;
+		MatrixKeypadSim_level[i] = LOW;
+		MatrixKeypadSim_changed[i] = 0;
+		MatrixKeypadSim_isr[i] = NULL;
+		for(j = 0; j < MATRIXKEYPAD_SIM_PINS; j++){
+			MatrixKeypadSim_keys[i][j].pressed = 0;
+			MatrixKeypadSim_keys[i][j].since = 0;
+		}
+	}
+	MatrixKeypadSim_clock = 1; /* "since" is 0 for the keys never touched */
+	MatrixKeypadSim_writes = 0;
+	MatrixKeypadSim_reads = 0;
+}
+
+void MatrixKeypadSim_press (uint8_t rowPin, uint8_t colPin){
+
+	MatrixKeypadSim_keys[rowPin][colPin].pressed = 1;
+	MatrixKeypadSim_keys[rowPin][colPin].since = MatrixKeypadSim_clock;
+	MatrixKeypadSim_checkInterrupts();
+}
+
+void MatrixKeypadSim_release (uint8_t rowPin, uint8_t colPin){
+
+	MatrixKeypadSim_keys[rowPin][colPin].pressed = 0;
+	MatrixKeypadSim_keys[rowPin][colPin].since = MatrixKeypadSim_clock;
+	MatrixKeypadSim_checkInterrupts();
+}
+
+void MatrixKeypadSim_setBounce (uint32_t us){
+	MatrixKeypadSim_bounce = (uint64_t)us * 1000;
+}
+
+void MatrixKeypadSim_setSettle (uint32_t ns){
+	MatrixKeypadSim_settle = ns;
+}
+
+void MatrixKeypadSim_setCosts (uint32_t writeNs, uint32_t readNs){
+	MatrixKeypadSim_writeCost = writeNs;
+	MatrixKeypadSim_readCost = readNs;
+}
+
+void MatrixKeypadSim_setDiodes (uint8_t diodes){
+	MatrixKeypadSim_diodes = diodes;
+}
+
+void MatrixKeypadSim_advance (uint32_t us){
+
+	uint64_t end = MatrixKeypadSim_clock + (uint64_t)us * 1000;
+
+	while(MatrixKeypadSim_clock < end) { /* in steps, so the interrupts see the bounces */
+		MatrixKeypadSim_clock += (end - MatrixKeypadSim_clock < MATRIXKEYPAD_SIM_BOUNCE_STEP) ? end - MatrixKeypadSim_clock : MATRIXKEYPAD_SIM_BOUNCE_STEP;
+		MatrixKeypadSim_checkInterrupts();
+	}
+}
+
+uint64_t MatrixKeypadSim_now (void){
+	return MatrixKeypadSim_clock;
+}
+
+uint32_t MatrixKeypadSim_getWrites (void){
+	return MatrixKeypadSim_writes;
+}
+
+uint32_t MatrixKeypadSim_getReads (void){
+	return MatrixKeypadSim_reads;
+}
+
+/* Host HAL */
+
+void pinMode (uint8_t pin, uint8_t mode){
+
+	if(pin >= MATRIXKEYPAD_SIM_PINS) {
+		return;
+	}
+
+	MatrixKeypadSim_mode[pin] = mode;
+	MatrixKeypadSim_changed[pin] = MatrixKeypadSim_clock;
+}
+
+void digitalWrite (uint8_t pin, uint8_t level){
+
+	MatrixKeypadSim_clock += MatrixKeypadSim_writeCost;
+	MatrixKeypadSim_writes++;
+	if(pin >= MATRIXKEYPAD_SIM_PINS || MatrixKeypadSim_level[pin] == (level != LOW)) {
+		return;
+	}
+
+	MatrixKeypadSim_level[pin] = (level != LOW);
+	MatrixKeypadSim_changed[pin] = MatrixKeypadSim_clock;
+	MatrixKeypadSim_checkInterrupts();
+}
+
+int digitalRead (uint8_t pin){
+
+	MatrixKeypadSim_clock += MatrixKeypadSim_readCost;
+	MatrixKeypadSim_reads++;
+	if(pin >= MATRIXKEYPAD_SIM_PINS) {
+		return LOW;
+	}
+
+	return MatrixKeypadSim_pinLevel(pin);
+}
+
+unsigned long millis (void){
+	return (unsigned long)(MatrixKeypadSim_clock / 1000000);
+}
+
+unsigned long micros (void){
+	return (unsigned long)(MatrixKeypadSim_clock / 1000);
+}
+
+void delay (unsigned long ms){
+	MatrixKeypadSim_advance(ms * 1000);
+}
+
+void delayMicroseconds (unsigned int us){
+	MatrixKeypadSim_advance(us);
+}
+
+void yield (void){
+	MatrixKeypadSim_advance(1);
+}
+
+void noInterrupts (void){
+}
+
+void interrupts (void){
+}
+
+void attachInterrupt (uint8_t interrupt, void (*isr)(void), int mode){
+
+	(void)mode; /* the library only uses FALLING */
+	if(interrupt >= MATRIXKEYPAD_SIM_PINS) {
+		return;
+	}
+
+	MatrixKeypadSim_isrLevel[interrupt] = MatrixKeypadSim_pinLevel(interrupt);
+	MatrixKeypadSim_isr[interrupt] = isr;
+}
+
+void detachInterrupt (uint8_t interrupt){
+
+	if(interrupt < MATRIXKEYPAD_SIM_PINS) {
+		MatrixKeypadSim_isr[interrupt] = NULL;
+	}
+}
@@ -0,0 +1,113 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_sim.h
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Simulated keypad matrix for the host HAL (Arduino.h of this directory).
+ *
+ * The simulation runs on a virtual clock. Each pin access advances it by the cost of the access (MatrixKeypadSim_setCosts),
+ * so the time measured by millis and micros is the time the scan would take on the target and not on the host.
+ * A key connects a row pin to a column pin. A column reads LOW if a key connects it to a row driven LOW for at least the settle time.
+ * After a key is pressed or released, its contact bounces for the bounce time. Without diodes, three keys in the corners of a rectangle also connect the fourth corner.
+ *
+@code{.c}
+#include "MatrixKeypad.h"
+#include "MatrixKeypad_sim.h"
+
+MatrixKeypadSim_reset();
+MatrixKeypad_init(&keypad, (char*)keymap, rowPins, colPins, 4, 3);
+MatrixKeypadSim_press(rowPins[1], colPins[2]); //presses '6'
+MatrixKeypadSim_advance(10000); //waits for the contact to stop bouncing
+MatrixKeypad_scan(&keypad);
+@endcode
+ */
+#ifndef MATRIXKEYPAD_SIM_H
+#define MATRIXKEYPAD_SIM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#define MATRIXKEYPAD_SIM_PINS 64 /**< Number of simulated pins */
+
+/**
+ * Releases all keys, resets the pins, the counters and the virtual clock. The timing parameters are kept.
+ */
+void MatrixKeypadSim_reset (void);
+
+/**
+ * Presses the key that connects the pins "rowPin" and "colPin". The contact bounces for the bounce time.
+ */
+void MatrixKeypadSim_press (uint8_t rowPin, uint8_t colPin);
+
+/**
+ * Releases the key that connects the pins "rowPin" and "colPin". The contact bounces for the bounce time.
+ */
+void MatrixKeypadSim_release (uint8_t rowPin, uint8_t colPin);
+
+/**
+ * Sets the time the contacts bounce after a press or a release, in microseconds. 0 disables the bounce. Default: 0.
+ */
+void MatrixKeypadSim_setBounce (uint32_t us);
+
+/**
+ * Sets the time a column takes to follow a row, in nanoseconds. Models the capacitance of long cables. Default: 0.
+ */
+void MatrixKeypadSim_setSettle (uint32_t ns);
+
+/**
+ * Sets the virtual time spent by each digitalWrite and digitalRead, in nanoseconds. The defaults are close to the Arduino core of the ATmega328P at 16MHz.
+ */
+void MatrixKeypadSim_setCosts (uint32_t writeNs, uint32_t readNs);
+
+/**
+ * Sets if the keys have diodes. Without them, the rectangles of pressed keys create ghost keys. Default: 1 (with diodes).
+ */
+void MatrixKeypadSim_setDiodes (uint8_t diodes);
+
+/**
+ * Advances the virtual clock, as if the sketch did something else for "us" microseconds. Fires the column interrupts of the keys that bounce in this time.
+ */
+void MatrixKeypadSim_advance (uint32_t us);
+
+/**
+ * Returns the virtual clock in nanoseconds.
+ */
+uint64_t MatrixKeypadSim_now (void);
+
+/**
+ * Returns the number of digitalWrite calls since the last reset.
+ */
+uint32_t MatrixKeypadSim_getWrites (void);
+
+/**
+ * Returns the number of digitalRead calls since the last reset.
+ */
+uint32_t MatrixKeypadSim_getReads (void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,838 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_test.c
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Tests of the library on the simulated matrix. Build and run them from the root of the repository:
+ *
+ *     cc -Wall -Iextras/host -Isrc src/MatrixKeypad.c extras/host/MatrixKeypad_sim.c extras/host/MatrixKeypad_test.c -o test
+ *     ./test
+ *
+ * Add the compile options to be tested to the command, for example "-DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_DEBOUNCE=1".
+ * The tests of the disabled options are skipped. MatrixKeypad_test.sh runs them with the main sets of options.
+ *
+ * Each failed check prints its line. The program returns 0 if all checks passed or 1 otherwise.
+ */
+#include "Arduino.h"
+#include "MatrixKeypad.h"
+#include "MatrixKeypad_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MATRIXKEYPAD_TEST_CHECK(condition) MatrixKeypadTest_check((condition), #condition, __LINE__)
+
+/* Frames scanned after each change of the keys, enough for the debounce to accept it */
+#if MATRIXKEYPAD_DEBOUNCE
+	#define MATRIXKEYPAD_TEST_FRAMES (MATRIXKEYPAD_DEBOUNCE_COUNT + 2)
+#else
+	#define MATRIXKEYPAD_TEST_FRAMES 2
+#endif
+
+static const uint8_t MatrixKeypadTest_rowPins[4] = {0, 1, 2, 3};
+static const uint8_t MatrixKeypadTest_colPins[3] = {10, 11, 12};
+static const char MatrixKeypadTest_keymap[4][3] = {
+	{'1','2','3'},
+	{'4','5','6'},
+	{'7','8','9'},
+	{'*','0','#'}
+};
+/* MatrixKeypad_initLayout works with and without MATRIXKEYPAD_COMPACT */
+static const MatrixKeypad_layout_t MatrixKeypadTest_layout = MATRIXKEYPAD_LAYOUT_INITIALIZER((const char*)MatrixKeypadTest_keymap, MatrixKeypadTest_rowPins, MatrixKeypadTest_colPins, 4, 3);
+/* Other keypads of the array and group tests: one on the same rows and one on its own rows */
+static const uint8_t MatrixKeypadTest_sharedCols[3] = {20, 21, 22};
+static const uint8_t MatrixKeypadTest_otherRows[4] = {4, 5, 6, 7};
+static const MatrixKeypad_layout_t MatrixKeypadTest_shared = MATRIXKEYPAD_LAYOUT_INITIALIZER((const char*)MatrixKeypadTest_keymap, MatrixKeypadTest_rowPins, MatrixKeypadTest_sharedCols, 4, 3);
+static const MatrixKeypad_layout_t MatrixKeypadTest_other = MATRIXKEYPAD_LAYOUT_INITIALIZER((const char*)MatrixKeypadTest_keymap, MatrixKeypadTest_otherRows, MatrixKeypadTest_colPins, 4, 3);
+
+static MatrixKeypad_t MatrixKeypadTest_keypad;
+static unsigned MatrixKeypadTest_failures = 0;
+
+static void MatrixKeypadTest_check (int condition, const char *text, int line){
+
+	if(!condition) {
+		printf("MatrixKeypad_test.c:%d: check failed: %s\n", line, text);
+		MatrixKeypadTest_failures++;
+	}
+}
+
+/* Resets the simulation and initializes the keypad */
+static MatrixKeypad_t *MatrixKeypadTest_setup (void){
+
+	MatrixKeypadSim_reset();
+	MatrixKeypadSim_setBounce(0);
+	MatrixKeypadSim_setDiodes(1);
+	MatrixKeypadSim_setSettle(0);
+	MatrixKeypadSim_setCosts(0, 0);
+	MatrixKeypadSim_advance(1000000); /* millis starts at 1s, like a sketch after the setup */
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&MatrixKeypadTest_keypad, &MatrixKeypadTest_layout) != NULL);
+
+	return &MatrixKeypadTest_keypad;
+}
+
+/* Scans "frames" frames, one each "interval" microseconds */
+static void MatrixKeypadTest_scan (MatrixKeypad_t *keypad, uint8_t frames, uint32_t interval){
+
+	while(frames--) {
+		MatrixKeypad_scan(keypad);
+		MatrixKeypadSim_advance(interval);
+	}
+}
+
+static void MatrixKeypadTest_press (MatrixKeypad_t *keypad, uint8_t row, uint8_t col){
+
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[row], MatrixKeypadTest_colPins[col]);
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+}
+
+static void MatrixKeypadTest_release (MatrixKeypad_t *keypad, uint8_t row, uint8_t col){
+
+	MatrixKeypadSim_release(MatrixKeypadTest_rowPins[row], MatrixKeypadTest_colPins[col]);
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+}
+
+/* Reads all keys available, returns how many were read */
+static uint8_t MatrixKeypadTest_count (MatrixKeypad_t *keypad){
+
+	uint8_t count = 0;
+
+	while(MatrixKeypad_hasKey(keypad)) {
+		MatrixKeypad_getKey(keypad);
+		count++;
+	}
+
+	return count;
+}
+
+/* A key is read once per press, a held key isn't read again */
+static void MatrixKeypadTest_pressRelease (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '\0');
+
+	MatrixKeypadTest_press(keypad, 1, 2);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_hasKey(keypad));
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '6');
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+	MatrixKeypadTest_scan(keypad, 20, 1000); /* held */
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+	MatrixKeypadTest_release(keypad, 1, 2);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+
+	MatrixKeypadTest_press(keypad, 1, 2); /* the same key again */
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '6');
+	MatrixKeypadTest_release(keypad, 1, 2);
+
+	MatrixKeypadTest_press(keypad, 3, 0); /* the corners of the matrix */
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '*');
+	MatrixKeypadTest_release(keypad, 3, 0);
+	MatrixKeypadTest_press(keypad, 0, 2);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '3');
+	MatrixKeypadTest_release(keypad, 0, 2);
+
+	MatrixKeypadTest_press(keypad, 2, 1);
+	MatrixKeypad_flush(keypad);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+	MatrixKeypadTest_release(keypad, 2, 1);
+}
+
+/* A bouncing contact is read as a single press */
+static void MatrixKeypadTest_bounce (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	uint8_t i, count = 0;
+
+	MatrixKeypadSim_setBounce(2000);
+#if MATRIXKEYPAD_DEBOUNCE
+	MatrixKeypad_setDebounce(keypad, 3); /* a change must be seen by 3 frames in a row, the bounce lasts less than 3 frames */
+#endif
+	for(i = 0; i < 3; i++){
+		MatrixKeypadSim_press(MatrixKeypadTest_rowPins[2], MatrixKeypadTest_colPins[2]);
+#if MATRIXKEYPAD_DEBOUNCE
+		MatrixKeypadTest_scan(keypad, 10, 1000);
+#else
+		/* without the debounce, the frames must be further apart than the bounce */
+		MatrixKeypadTest_scan(keypad, 3, 5000);
+#endif
+		count += MatrixKeypadTest_count(keypad);
+		MatrixKeypadSim_release(MatrixKeypadTest_rowPins[2], MatrixKeypadTest_colPins[2]);
+#if MATRIXKEYPAD_DEBOUNCE
+		MatrixKeypadTest_scan(keypad, 10, 1000);
+#else
+		MatrixKeypadTest_scan(keypad, 3, 5000);
+#endif
+		count += MatrixKeypadTest_count(keypad);
+	}
+	MATRIXKEYPAD_TEST_CHECK(count == 3);
+}
+
+#if MATRIXKEYPAD_DEBOUNCE
+/* A change is only accepted after it is seen in "count" frames in a row */
+static void MatrixKeypadTest_debounce (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_setDebounce(keypad, 0));
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_setDebounce(keypad, 1 << MATRIXKEYPAD_DEBOUNCE_BITS));
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_setDebounce(keypad, 3));
+
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[1]);
+	MatrixKeypadTest_scan(keypad, 2, 1000);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+	MatrixKeypadTest_scan(keypad, 1, 1000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '5');
+
+	MatrixKeypadSim_release(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[1]);
+	MatrixKeypadTest_scan(keypad, 2, 1000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_isKeyPressed(keypad, '5'));
+	MatrixKeypadTest_scan(keypad, 1, 1000);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_isKeyPressed(keypad, '5'));
+
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[1]); /* a glitch of two frames */
+	MatrixKeypadTest_scan(keypad, 2, 1000);
+	MatrixKeypadSim_release(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[1]);
+	MatrixKeypadTest_scan(keypad, 5, 1000);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+}
+#endif
+
+#if MATRIXKEYPAD_MULTIKEY
+/* Without diodes, three keys in the corners of a rectangle also connect the fourth corner */
+static void MatrixKeypadTest_ghost (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+
+	MatrixKeypadSim_setDiodes(0);
+	MatrixKeypadTest_press(keypad, 0, 0);
+	MatrixKeypadTest_press(keypad, 0, 1);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getPressedCount(keypad) == 2);
+	MatrixKeypadTest_press(keypad, 1, 0); /* '5' reads as pressed */
+#if MATRIXKEYPAD_GHOST
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_isGhosted(keypad));
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_isKeyPressed(keypad, '1') && MatrixKeypad_isKeyPressed(keypad, '2'));
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_isKeyPressed(keypad, '4') && !MatrixKeypad_isKeyPressed(keypad, '5'));
+#else
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_isKeyPressed(keypad, '5'));
+#endif
+	MatrixKeypadTest_release(keypad, 0, 1); /* the rectangle is open again */
+#if MATRIXKEYPAD_GHOST
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_isGhosted(keypad));
+#endif
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_isKeyPressed(keypad, '1') && MatrixKeypad_isKeyPressed(keypad, '4'));
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_isKeyPressed(keypad, '2') && !MatrixKeypad_isKeyPressed(keypad, '5'));
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getPressedCount(keypad) == 2);
+}
+#endif
+
+#if MATRIXKEYPAD_USE_QUEUE && !MATRIXKEYPAD_EVENTS
+/* The keys are read in order and the ones that don't fit in the queue are dropped and counted */
+static void MatrixKeypadTest_queue (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	uint8_t i;
+
+	for(i = 0; i <= MATRIXKEYPAD_QUEUE_SIZE; i++){
+		MatrixKeypadTest_press(keypad, (i % 12) / 3, i % 3);
+		MatrixKeypadTest_release(keypad, (i % 12) / 3, i % 3);
+	}
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getQueueDepth(keypad) == MATRIXKEYPAD_QUEUE_SIZE);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getOverflowCount(keypad) == 1);
+	for(i = 0; i < MATRIXKEYPAD_QUEUE_SIZE; i++){
+		MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == ((const char *)MatrixKeypadTest_keymap)[i % 12]);
+	}
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+}
+#endif
+
+#if MATRIXKEYPAD_EVENTS
+/* A press and a release are two events with the index of the key and their time */
+static void MatrixKeypadTest_events (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	MatrixKeypad_event_t press, release;
+	uint8_t i;
+
+	MatrixKeypadTest_press(keypad, 1, 1);
+	MatrixKeypadSim_advance(120000);
+	MatrixKeypadTest_release(keypad, 1, 1);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getQueueDepth(keypad) == 2);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getEvent(keypad, &press) && press.type == MATRIXKEYPAD_EVENT_PRESS && press.key == 4);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getEvent(keypad, &release) && release.type == MATRIXKEYPAD_EVENT_RELEASE && release.key == 4);
+	MATRIXKEYPAD_TEST_CHECK((uint16_t)(release.time - press.time) >= 120 && (uint16_t)(release.time - press.time) < 130);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_getEvent(keypad, &press));
+
+	MatrixKeypadTest_press(keypad, 3, 2); /* MatrixKeypad_getKey skips the releases */
+	MatrixKeypadTest_release(keypad, 3, 2);
+	MatrixKeypadTest_press(keypad, 0, 0);
+	MatrixKeypadTest_release(keypad, 0, 0);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '#');
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '1');
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+
+	for(i = 0; i < MATRIXKEYPAD_QUEUE_SIZE; i++){ /* two events each, half of them fit */
+		MatrixKeypadTest_press(keypad, 0, 0);
+		MatrixKeypadTest_release(keypad, 0, 0);
+	}
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getQueueDepth(keypad) == MATRIXKEYPAD_QUEUE_SIZE);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getOverflowCount(keypad) == MATRIXKEYPAD_QUEUE_SIZE);
+}
+#endif
+
+#if MATRIXKEYPAD_REPEAT
+/* A held key repeats after the delay, at the interval, and is reported once as held */
+static void MatrixKeypadTest_repeat (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	MatrixKeypad_event_t event;
+	uint8_t repeats = 0, holds = 0;
+
+	MatrixKeypad_setRepeat(keypad, 100, 50, 200);
+	MatrixKeypadTest_press(keypad, 2, 0);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '7');
+	MatrixKeypadTest_scan(keypad, 27, 10000); /* repeats at 100, 150, 200 and 250ms, held at 200ms */
+	while(MatrixKeypad_getEvent(keypad, &event)) {
+		repeats += event.type == MATRIXKEYPAD_EVENT_REPEAT && event.key == 6;
+		holds += event.type == MATRIXKEYPAD_EVENT_HOLD && event.key == 6;
+	}
+	MATRIXKEYPAD_TEST_CHECK(repeats == 4);
+	MATRIXKEYPAD_TEST_CHECK(holds == 1);
+
+	MatrixKeypadTest_release(keypad, 2, 0);
+	MatrixKeypadTest_scan(keypad, 30, 10000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getEvent(keypad, &event) && event.type == MATRIXKEYPAD_EVENT_RELEASE);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+
+	MatrixKeypad_setRepeat(keypad, 0, 50, 0); /* disabled */
+	MatrixKeypadTest_press(keypad, 2, 0);
+	MatrixKeypadTest_scan(keypad, 30, 10000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypadTest_count(keypad) == 1);
+	MatrixKeypadTest_release(keypad, 2, 0);
+}
+#endif
+
+#if MATRIXKEYPAD_CALLBACKS
+static char MatrixKeypadTest_log[32];
+
+static void MatrixKeypadTest_onPress (MatrixKeypad_t *keypad, char key){
+
+	size_t length = strlen(MatrixKeypadTest_log);
+
+	(void)keypad;
+	if(length + 2 < sizeof(MatrixKeypadTest_log)) {
+		MatrixKeypadTest_log[length] = '+';
+		MatrixKeypadTest_log[length + 1] = key;
+		MatrixKeypadTest_log[length + 2] = '\0';
+	}
+}
+
+static void MatrixKeypadTest_onRelease (MatrixKeypad_t *keypad, char key){
+
+	size_t length = strlen(MatrixKeypadTest_log);
+
+	(void)keypad;
+	if(length + 2 < sizeof(MatrixKeypadTest_log)) {
+		MatrixKeypadTest_log[length] = '-';
+		MatrixKeypadTest_log[length + 1] = key;
+		MatrixKeypadTest_log[length + 2] = '\0';
+	}
+}
+
+/* Runs the deferred callbacks, if they are deferred */
+static void MatrixKeypadTest_dispatch (MatrixKeypad_t *keypad){
+
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+	MatrixKeypad_dispatch(keypad);
+#else
+	(void)keypad;
+#endif
+}
+
+/* Each press and release calls its callback once, with the key */
+static void MatrixKeypadTest_callbacks (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+
+	MatrixKeypadTest_log[0] = '\0';
+	MatrixKeypad_setCallbacks(keypad, MatrixKeypadTest_onPress, MatrixKeypadTest_onRelease);
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MatrixKeypadTest_dispatch(keypad);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypadTest_log[0] == '\0');
+
+	MatrixKeypadTest_press(keypad, 1, 2);
+	MatrixKeypadTest_dispatch(keypad);
+	MATRIXKEYPAD_TEST_CHECK(strcmp(MatrixKeypadTest_log, "+6") == 0);
+	MatrixKeypadTest_release(keypad, 1, 2);
+	MatrixKeypadTest_dispatch(keypad);
+	MatrixKeypadTest_press(keypad, 0, 0); /* a tap between two dispatches */
+	MatrixKeypadTest_release(keypad, 0, 0);
+	MatrixKeypadTest_dispatch(keypad);
+	MATRIXKEYPAD_TEST_CHECK(strcmp(MatrixKeypadTest_log, "+6-6+1-1") == 0);
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_dispatch(keypad) == 0);
+#endif
+
+	MatrixKeypad_setCallbacks(keypad, NULL, NULL);
+	MatrixKeypadTest_press(keypad, 1, 2);
+	MatrixKeypadTest_release(keypad, 1, 2);
+	MatrixKeypadTest_dispatch(keypad);
+	MATRIXKEYPAD_TEST_CHECK(strcmp(MatrixKeypadTest_log, "+6-6+1-1") == 0);
+}
+#endif
+
+#if !MATRIXKEYPAD_COMPACT
+/* MatrixKeypad_destroy only releases the keypads allocated by MatrixKeypad_create */
+static void MatrixKeypadTest_destroy (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	MatrixKeypad_t *created = MatrixKeypad_create((const char*)MatrixKeypadTest_keymap, MatrixKeypadTest_rowPins, MatrixKeypadTest_colPins, 4, 3);
+
+	MATRIXKEYPAD_TEST_CHECK(created != NULL && created->allocated);
+	MATRIXKEYPAD_TEST_CHECK(!keypad->allocated);
+	MatrixKeypad_destroy(created);
+	MatrixKeypad_destroy(NULL);
+
+	MatrixKeypad_destroy(keypad); /* a static keypad, the memory isn't released */
+	MatrixKeypadTest_press(keypad, 0, 1);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '2');
+	MatrixKeypadTest_release(keypad, 0, 1);
+}
+#endif
+
+#if MATRIXKEYPAD_USE_STEP
+/* The frame is spread over the calls of MatrixKeypad_step, up to one per row */
+static void MatrixKeypadTest_step (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	uint8_t frame, calls, done;
+
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[3], MatrixKeypadTest_colPins[1]);
+	for(frame = 0; frame < MATRIXKEYPAD_TEST_FRAMES; frame++){
+		for(calls = 0, done = 0; calls < 4 && !done; calls++){
+			done = MatrixKeypad_step(keypad);
+		}
+		MATRIXKEYPAD_TEST_CHECK(done);
+		MatrixKeypadSim_advance(1000);
+	}
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '0');
+
+	MatrixKeypad_step(keypad); /* MatrixKeypad_scan discards the frame in progress */
+	MatrixKeypadTest_release(keypad, 3, 1);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+}
+#endif
+
+#if MATRIXKEYPAD_MULTIKEY && MATRIXKEYPAD_MAX_ROWS * MATRIXKEYPAD_MAX_COLS > 256
+/* The keys after the 256th are read from their own place of the key mapping */
+static void MatrixKeypadTest_large (void){
+
+	static uint8_t rowPins[12], colPins[32];
+	static char keymap[12 * 32];
+	static const MatrixKeypad_layout_t layout = MATRIXKEYPAD_LAYOUT_INITIALIZER(keymap, rowPins, colPins, 12, 32);
+	static MatrixKeypad_t keypad;
+	uint16_t i;
+
+	MatrixKeypadTest_setup();
+	for(i = 0; i < 12; i++){
+		rowPins[i] = i;
+	}
+	for(i = 0; i < 32; i++){
+		colPins[i] = 20 + i;
+	}
+	for(i = 0; i < sizeof(keymap); i++){
+		keymap[i] = 'a' + i % 26;
+	}
+	keymap[11 * 32 + 31] = '!'; /* the last key, index 383 */
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&keypad, &layout) != NULL);
+#if MATRIXKEYPAD_CALLBACKS
+	MatrixKeypadTest_log[0] = '\0';
+	MatrixKeypad_setCallbacks(&keypad, MatrixKeypadTest_onPress, MatrixKeypadTest_onRelease);
+#endif
+
+	MatrixKeypadSim_press(rowPins[11], colPins[31]);
+	MatrixKeypadTest_scan(&keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_isKeyPressed(&keypad, '!'));
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(&keypad) == '!');
+	MatrixKeypadSim_release(rowPins[11], colPins[31]);
+	MatrixKeypadTest_scan(&keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_isKeyPressed(&keypad, '!'));
+#if MATRIXKEYPAD_CALLBACKS
+	MatrixKeypadTest_dispatch(&keypad);
+	MATRIXKEYPAD_TEST_CHECK(strcmp(MatrixKeypadTest_log, "+!-!") == 0);
+#endif
+}
+#endif
+
+/* The neighbours that share their rows are strobed together, the other keypads are scanned on their own */
+static void MatrixKeypadTest_array (void){
+
+	static MatrixKeypad_t keypads[4];
+	uint32_t writes, separate;
+	uint8_t frame, i;
+
+	MatrixKeypadTest_setup();
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&keypads[0], &MatrixKeypadTest_layout) != NULL);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&keypads[1], &MatrixKeypadTest_shared) != NULL);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&keypads[2], &MatrixKeypadTest_layout) != NULL);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&keypads[3], &MatrixKeypadTest_other) != NULL);
+
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[2]); /* read by keypads 0 and 2 */
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[3], MatrixKeypadTest_sharedCols[0]);
+	MatrixKeypadSim_press(MatrixKeypadTest_otherRows[2], MatrixKeypadTest_colPins[1]);
+	for(frame = 0; frame < MATRIXKEYPAD_TEST_FRAMES; frame++){
+		MatrixKeypad_scanArray(keypads, 4);
+		MatrixKeypadSim_advance(1000);
+	}
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(&keypads[0]) == '6');
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(&keypads[1]) == '*');
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(&keypads[2]) == '6');
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(&keypads[3]) == '8');
+
+	writes = MatrixKeypadSim_getWrites();
+	MatrixKeypad_scanArray(keypads, 4);
+	writes = MatrixKeypadSim_getWrites() - writes;
+	separate = MatrixKeypadSim_getWrites();
+	for(i = 0; i < 4; i++){
+		MatrixKeypad_scan(&keypads[i]);
+	}
+	separate = MatrixKeypadSim_getWrites() - separate;
+#if MATRIXKEYPAD_USE_SHARED
+	MATRIXKEYPAD_TEST_CHECK(writes < separate); /* the first three keypads share one strobe of the rows */
+#else
+	MATRIXKEYPAD_TEST_CHECK(writes == separate);
+#endif
+	for(i = 0; i < 4; i++){
+		MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(&keypads[i]));
+	}
+}
+
+#if MATRIXKEYPAD_GROUP
+/* The keypads of a group share the strobes of their rows and keep their own keys */
+static void MatrixKeypadTest_group (void){
+
+	static MatrixKeypad_t shared, other;
+	static MatrixKeypad_t *keypads[2], *mixed[2];
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	MatrixKeypad_group_t group;
+	uint32_t writes, separate;
+	uint8_t frame;
+
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&shared, &MatrixKeypadTest_shared) != NULL);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initLayout(&other, &MatrixKeypadTest_other) != NULL);
+	mixed[0] = keypad;
+	mixed[1] = &other;
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_initGroup(&group, mixed, 2)); /* the rows aren't shared */
+	keypads[0] = keypad;
+	keypads[1] = &shared;
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initGroup(&group, keypads, 2));
+
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[0], MatrixKeypadTest_colPins[1]);
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[2], MatrixKeypadTest_sharedCols[2]);
+	for(frame = 0; frame < MATRIXKEYPAD_TEST_FRAMES; frame++){
+		MatrixKeypad_scanGroup(&group);
+		MatrixKeypadSim_advance(1000);
+	}
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '2');
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(&shared) == '9');
+
+	writes = MatrixKeypadSim_getWrites();
+	MatrixKeypad_scanGroup(&group);
+	writes = MatrixKeypadSim_getWrites() - writes;
+	separate = MatrixKeypadSim_getWrites();
+	MatrixKeypad_scan(keypad);
+	MatrixKeypad_scan(&shared);
+	separate = MatrixKeypadSim_getWrites() - separate;
+	MATRIXKEYPAD_TEST_CHECK(writes < separate);
+
+	MatrixKeypadSim_release(MatrixKeypadTest_rowPins[0], MatrixKeypadTest_colPins[1]);
+	MatrixKeypadSim_release(MatrixKeypadTest_rowPins[2], MatrixKeypadTest_sharedCols[2]);
+	for(frame = 0; frame < MATRIXKEYPAD_TEST_FRAMES; frame++){
+		MatrixKeypad_scanGroup(&group);
+		MatrixKeypadSim_advance(1000);
+	}
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad) && !MatrixKeypad_hasKey(&shared));
+}
+#endif
+
+#if MATRIXKEYPAD_STATS
+/* The frames, their durations and gaps, the overwritten keys and the read latency are counted */
+static void MatrixKeypadTest_stats (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+	MatrixKeypad_stats_t stats;
+
+	MatrixKeypadSim_setCosts(1000, 1000); /* 1us per pin access, so the frames take some time */
+	MatrixKeypadTest_scan(keypad, 10, 1000);
+	MatrixKeypadTest_scan(keypad, 1, 5000);
+	MatrixKeypadTest_scan(keypad, 1, 1000);
+	MatrixKeypad_getStats(keypad, &stats);
+	MATRIXKEYPAD_TEST_CHECK(stats.scans == 12);
+	MATRIXKEYPAD_TEST_CHECK(stats.worstTime > 0 && stats.worstTime < 1000);
+	MATRIXKEYPAD_TEST_CHECK(stats.averageTime > 0 && stats.averageTime <= stats.worstTime);
+	MATRIXKEYPAD_TEST_CHECK(stats.maxGap >= 5000 && stats.maxGap < 6000);
+
+	MatrixKeypadTest_press(keypad, 1, 2);
+	MatrixKeypadSim_advance(5000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '6');
+	MatrixKeypad_getStats(keypad, &stats);
+	MATRIXKEYPAD_TEST_CHECK(stats.latency[3] == 1); /* read 5 to 7ms after the detection */
+	MatrixKeypadTest_release(keypad, 1, 2);
+
+#if !MATRIXKEYPAD_USE_QUEUE
+	MatrixKeypadTest_press(keypad, 0, 0); /* not read before the next key */
+	MatrixKeypadTest_release(keypad, 0, 0);
+	MatrixKeypadTest_press(keypad, 0, 1);
+	MatrixKeypadTest_release(keypad, 0, 1);
+	MatrixKeypad_getStats(keypad, &stats);
+	MATRIXKEYPAD_TEST_CHECK(stats.overwrites == 1);
+#endif
+
+	MatrixKeypad_resetStats(keypad);
+	MatrixKeypad_getStats(keypad, &stats);
+	MATRIXKEYPAD_TEST_CHECK(stats.scans == 0 && stats.worstTime == 0 && stats.latency[3] == 0);
+}
+#endif
+
+#if MATRIXKEYPAD_SETTLE
+/* A slow row is only read right after the settle time */
+static void MatrixKeypadTest_settle (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+
+	MatrixKeypadSim_setSettle(3000); /* the rows take 3us to reach their level */
+	MatrixKeypad_setSettleTime(keypad, 0);
+	MatrixKeypadTest_press(keypad, 1, 2);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) != '6'); /* the row is read HIGH and, once released, still LOW under the next rows */
+
+	MatrixKeypad_setSettleTime(keypad, 5);
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '6');
+	MatrixKeypadTest_release(keypad, 1, 2);
+}
+#endif
+
+#if MATRIXKEYPAD_ADAPTIVE
+/* Counts the scans of MatrixKeypad_poll called each millisecond for "ms" milliseconds */
+static uint8_t MatrixKeypadTest_poll (MatrixKeypad_t *keypad, uint8_t ms){
+
+	uint8_t scans = 0;
+
+	while(ms--) {
+		scans += MatrixKeypad_poll(keypad);
+		MatrixKeypadSim_advance(1000);
+	}
+
+	return scans;
+}
+
+/* The keypad is scanned at the idle interval until a key is pressed, then at the active interval */
+static void MatrixKeypadTest_adaptive (void){
+
+	MatrixKeypad_t *keypad = MatrixKeypadTest_setup();
+
+	MatrixKeypad_setScanInterval(keypad, 10, 50);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypadTest_poll(keypad, 100) == 2);
+	MatrixKeypadSim_press(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[2]);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypadTest_poll(keypad, 100) == 10);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '6');
+	MatrixKeypadSim_release(MatrixKeypadTest_rowPins[1], MatrixKeypadTest_colPins[2]);
+	MatrixKeypadTest_poll(keypad, 10);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypadTest_poll(keypad, 100) == 2);
+}
+#endif
+
+#if MATRIXKEYPAD_TRANSPORT && !MATRIXKEYPAD_COMPACT
+/* A transport backed by the pins of the simulated matrix, that strobes the rows and reads the columns like a port expander */
+static void MatrixKeypadTest_transportBegin (void *context){
+
+	uint8_t i;
+
+	(void)context;
+	for(i = 0; i < 4; i++){
+		pinMode(MatrixKeypadTest_rowPins[i], OUTPUT);
+		digitalWrite(MatrixKeypadTest_rowPins[i], HIGH);
+	}
+	for(i = 0; i < 3; i++){
+		pinMode(MatrixKeypadTest_colPins[i], INPUT_PULLUP);
+	}
+}
+
+static void MatrixKeypadTest_transportSelect (void *context, uint8_t row){
+
+	uint8_t i;
+
+	(void)context;
+	for(i = 0; i < 4; i++){
+		digitalWrite(MatrixKeypadTest_rowPins[i], i == row ? LOW : HIGH);
+	}
+}
+
+static void MatrixKeypadTest_transportRelease (void *context){
+
+	MatrixKeypadTest_transportSelect(context, 0xFF);
+}
+
+static MatrixKeypad_cols_t MatrixKeypadTest_transportRead (void *context){
+
+	MatrixKeypad_cols_t cols = 0;
+	uint8_t i;
+
+	(void)context;
+	for(i = 0; i < 3; i++){
+		if(digitalRead(MatrixKeypadTest_colPins[i]) == LOW) {
+			cols |= (MatrixKeypad_cols_t)1 << i;
+		}
+	}
+
+	return cols;
+}
+
+static unsigned MatrixKeypadTest_probes = 0;
+
+static uint8_t MatrixKeypadTest_transportProbe (void *context){
+
+	uint8_t i;
+	MatrixKeypad_cols_t cols;
+
+	(void)context;
+	MatrixKeypadTest_probes++;
+	for(i = 0; i < 4; i++){
+		digitalWrite(MatrixKeypadTest_rowPins[i], LOW);
+	}
+	cols = MatrixKeypadTest_transportRead(context);
+	MatrixKeypadTest_transportRelease(context);
+
+	return cols != 0;
+}
+
+static MatrixKeypad_cols_t MatrixKeypadTest_frame[4]; /* frame "scanned by the hardware" of the frame transport */
+
+static void MatrixKeypadTest_frameBegin (void *context){
+
+	(void)context; /* the hardware is simulated by MatrixKeypadTest_frame */
+}
+
+static void MatrixKeypadTest_transportFrame (void *context, MatrixKeypad_cols_t *frame){
+
+	uint8_t i;
+
+	(void)context;
+	for(i = 0; i < 4; i++){
+		frame[i] = MatrixKeypadTest_frame[i];
+	}
+}
+
+/* The keys are read through the functions of the transport, or from the frames of a hardware scan */
+static void MatrixKeypadTest_transport (void){
+
+	static const MatrixKeypad_transport_t transport = {
+		MatrixKeypadTest_transportBegin, MatrixKeypadTest_transportSelect, MatrixKeypadTest_transportRelease,
+		MatrixKeypadTest_transportRead, MatrixKeypadTest_transportProbe, NULL, NULL, 0, 0
+	};
+	static const MatrixKeypad_transport_t hardware = {MatrixKeypadTest_frameBegin, NULL, NULL, NULL, NULL, MatrixKeypadTest_transportFrame, NULL, 4, 3};
+	MatrixKeypad_t *keypad;
+
+	MatrixKeypadTest_setup();
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initTransport(&MatrixKeypadTest_keypad, (const char*)MatrixKeypadTest_keymap, &transport, MATRIXKEYPAD_MAX_ROWS + 1, 3) == NULL); /* the frame holds up to MATRIXKEYPAD_MAX_ROWS rows */
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_initTransport(&MatrixKeypadTest_keypad, (const char*)MatrixKeypadTest_keymap, &hardware, 4, 2) == NULL); /* the hardware scans 4x3 */
+	keypad = MatrixKeypad_initTransport(&MatrixKeypadTest_keypad, (const char*)MatrixKeypadTest_keymap, &transport, 4, 3);
+	MATRIXKEYPAD_TEST_CHECK(keypad != NULL);
+	MatrixKeypadTest_probes = 0;
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypadTest_probes == MATRIXKEYPAD_TEST_FRAMES); /* the idle frames are probed */
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+	MatrixKeypadTest_press(keypad, 3, 2);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '#');
+	MatrixKeypadTest_release(keypad, 3, 2);
+	MatrixKeypadTest_press(keypad, 0, 0);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '1');
+	MatrixKeypadTest_release(keypad, 0, 0);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+
+	keypad = MatrixKeypad_initTransport(&MatrixKeypadTest_keypad, (const char*)MatrixKeypadTest_keymap, &hardware, 4, 3);
+	MATRIXKEYPAD_TEST_CHECK(keypad != NULL);
+	MatrixKeypadTest_frame[2] = 1 << 1;
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(MatrixKeypad_getKey(keypad) == '8');
+	MatrixKeypadTest_frame[2] = 0;
+	MatrixKeypadTest_scan(keypad, MATRIXKEYPAD_TEST_FRAMES, 1000);
+	MATRIXKEYPAD_TEST_CHECK(!MatrixKeypad_hasKey(keypad));
+}
+#endif
+
+int main (void){
+
+	MatrixKeypadTest_pressRelease();
+	MatrixKeypadTest_bounce();
+#if MATRIXKEYPAD_DEBOUNCE
+	MatrixKeypadTest_debounce();
+#endif
+#if MATRIXKEYPAD_MULTIKEY
+	MatrixKeypadTest_ghost();
+#endif
+#if MATRIXKEYPAD_USE_QUEUE && !MATRIXKEYPAD_EVENTS
+	MatrixKeypadTest_queue();
+#endif
+#if MATRIXKEYPAD_EVENTS
+	MatrixKeypadTest_events();
+#endif
+#if MATRIXKEYPAD_REPEAT
+	MatrixKeypadTest_repeat();
+#endif
+#if MATRIXKEYPAD_CALLBACKS
+	MatrixKeypadTest_callbacks();
+#endif
+#if !MATRIXKEYPAD_COMPACT
+	MatrixKeypadTest_destroy();
+#endif
+#if MATRIXKEYPAD_USE_STEP
+	MatrixKeypadTest_step();
+#endif
+	MatrixKeypadTest_array();
+#if MATRIXKEYPAD_GROUP
+	MatrixKeypadTest_group();
+#endif
+#if MATRIXKEYPAD_STATS
+	MatrixKeypadTest_stats();
+#endif
+#if MATRIXKEYPAD_SETTLE
+	MatrixKeypadTest_settle();
+#endif
+#if MATRIXKEYPAD_ADAPTIVE
+	MatrixKeypadTest_adaptive();
+#endif
+#if MATRIXKEYPAD_TRANSPORT && !MATRIXKEYPAD_COMPACT
+	MatrixKeypadTest_transport();
+#endif
+#if MATRIXKEYPAD_MULTIKEY && MATRIXKEYPAD_MAX_ROWS * MATRIXKEYPAD_MAX_COLS > 256
+	MatrixKeypadTest_large();
+#endif
+
+	if(MatrixKeypadTest_failures != 0) {
+		printf("%u checks failed\n", MatrixKeypadTest_failures);
+		return 1;
+	}
+	printf("all tests passed\n");
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Builds and runs MatrixKeypad_test.c with the main sets of compile options. Can be run from any directory.
+# Returns 0 if all sets passed.
+
+CC=${CC:-cc}
+HOST=$(dirname "$0")
+SRC="$HOST/../../src"
+OUT=${TMPDIR:-/tmp}/MatrixKeypad_test
+FAILED=0
+
+for OPTIONS in \
+	"" \
+	"-DMATRIXKEYPAD_FAST_IO=1 -DMATRIXKEYPAD_EARLY_EXIT=1" \
+	"-DMATRIXKEYPAD_MULTIKEY=1" \
+	"-DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_DEBOUNCE=1 -DMATRIXKEYPAD_GHOST=1" \
+	"-DMATRIXKEYPAD_QUEUE_SIZE=4" \
+	"-DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_QUEUE_SIZE=8 -DMATRIXKEYPAD_EVENTS=1 -DMATRIXKEYPAD_REPEAT=1" \
+	"-DMATRIXKEYPAD_CALLBACKS=1" \
+	"-DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_CALLBACKS=1 -DMATRIXKEYPAD_DEFERRED_CALLBACKS=1" \
+	"-DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_MAX_ROWS=12 -DMATRIXKEYPAD_MAX_COLS=32 -DMATRIXKEYPAD_CALLBACKS=1 -DMATRIXKEYPAD_DEFERRED_CALLBACKS=1" \
+	"-DMATRIXKEYPAD_TIMER=1 -DMATRIXKEYPAD_QUEUE_SIZE=4" \
+	"-DMATRIXKEYPAD_INTERRUPTS=1" \
+	"-DMATRIXKEYPAD_GROUP=1 -DMATRIXKEYPAD_EARLY_EXIT=1" \
+	"-DMATRIXKEYPAD_GROUP=1 -DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_DEBOUNCE=1" \
+	"-DMATRIXKEYPAD_STATS=1" \
+	"-DMATRIXKEYPAD_STATS=1 -DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_QUEUE_SIZE=8 -DMATRIXKEYPAD_EVENTS=1" \
+	"-DMATRIXKEYPAD_SETTLE=1 -DMATRIXKEYPAD_ADAPTIVE=1" \
+	"-DMATRIXKEYPAD_SETTLE=1 -DMATRIXKEYPAD_ADAPTIVE=1 -DMATRIXKEYPAD_MULTIKEY=1" \
+	"-DMATRIXKEYPAD_TRANSPORT=1" \
+	"-DMATRIXKEYPAD_TRANSPORT=1 -DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_EARLY_EXIT=1" \
+	"-DMATRIXKEYPAD_COMPACT=1 -DMATRIXKEYPAD_INDEX=1" \
+	"-DMATRIXKEYPAD_COMPACT=1 -DMATRIXKEYPAD_GROUP=1 -DMATRIXKEYPAD_EARLY_EXIT=1" \
+	"-DMATRIXKEYPAD_COMPACT=1 -DMATRIXKEYPAD_PROGMEM=1 -DMATRIXKEYPAD_MULTIKEY=1 -DMATRIXKEYPAD_DEBOUNCE=1 -DMATRIXKEYPAD_GHOST=1 -DMATRIXKEYPAD_QUEUE_SIZE=8 -DMATRIXKEYPAD_EVENTS=1 -DMATRIXKEYPAD_REPEAT=1 -DMATRIXKEYPAD_CALLBACKS=1 -DMATRIXKEYPAD_DEFERRED_CALLBACKS=1 -DMATRIXKEYPAD_TIMER=1"
+do
+	echo "options: ${OPTIONS:-(defaults)}"
+	if ! $CC -Wall -I"$HOST" -I"$SRC" $OPTIONS "$SRC/MatrixKeypad.c" "$HOST/MatrixKeypad_sim.c" "$HOST/MatrixKeypad_test.c" -o "$OUT" || ! "$OUT"; then
+		FAILED=1
+	fi
+done
+
+rm -f "$OUT"
+exit $FAILED
@@ -19,7 +19,7 @@
 */
 /** 
  * @file MatrixKeypad.c
- * @version 1.1.0
+ * @version 1.2.0
  * @author Victor Henrique Salvi
  * 
  * Simple to use c-like Arduino library to interface matrix keypads.
@@ -29,149 +29,2677 @@
 #include "Arduino.h"
 #include <stdlib.h>
 
-MatrixKeypad_t *MatrixKeypad_create (char *keymap, uint8_t *rowPins, uint8_t *colPins, uint8_t rown, uint8_t coln){
+#if MATRIXKEYPAD_USE_PORTS
+	#include <avr/io.h>
+#endif
+#if MATRIXKEYPAD_USE_ESP_TIMER
+	#include "esp_timer.h"
+#endif
+#if MATRIXKEYPAD_USE_RTOS_WAIT || MATRIXKEYPAD_USE_RTOS
+	#include "freertos/FreeRTOS.h"
+	#include "freertos/task.h"
+#elif MATRIXKEYPAD_WAIT_SLEEP && defined(__AVR__)
+	#include <avr/sleep.h>
+#endif
+#if MATRIXKEYPAD_DEEP_SLEEP && defined(ESP32)
+	#include "esp_sleep.h"
+	#include "driver/gpio.h"
+#endif
+#if MATRIXKEYPAD_USE_PGM
+	#include <avr/pgmspace.h>
+#endif
+#if defined(ESP32)
+	#include "freertos/FreeRTOS.h"
+#endif
+
+/* Reads the entry "i" of a key mapping or of a pin mapping */
+#if MATRIXKEYPAD_USE_PGM
+	#define MATRIXKEYPAD_KEY(keymap, i) ((char)pgm_read_byte(&(keymap)[i]))
+	#define MATRIXKEYPAD_PIN(pins, i) pgm_read_byte(&(pins)[i])
+#else
+	#define MATRIXKEYPAD_KEY(keymap, i) ((keymap)[i])
+	#define MATRIXKEYPAD_PIN(pins, i) ((pins)[i])
+#endif
+
+/* Critical sections against the background scan (the timer or the scan task).
+ * On ESP32 the scan can run on the other core, which disabling the interrupts of this core doesn't stop, so a spinlock is taken instead.
+ * The scan takes the spinlock too (MATRIXKEYPAD_SCAN_LOCK) where it writes the state that is read in a critical section. Elsewhere the scan runs in an ISR or between the critical sections */
+#if defined(ESP32)
+	static portMUX_TYPE MatrixKeypad_mux = portMUX_INITIALIZER_UNLOCKED;
+	#define MATRIXKEYPAD_ENTER_CRITICAL() portENTER_CRITICAL(&MatrixKeypad_mux)
+	#define MATRIXKEYPAD_EXIT_CRITICAL() portEXIT_CRITICAL(&MatrixKeypad_mux)
+	#define MATRIXKEYPAD_SCAN_LOCK() portENTER_CRITICAL(&MatrixKeypad_mux)
+	#define MATRIXKEYPAD_SCAN_UNLOCK() portEXIT_CRITICAL(&MatrixKeypad_mux)
+#else
+	#define MATRIXKEYPAD_ENTER_CRITICAL() noInterrupts()
+	#define MATRIXKEYPAD_EXIT_CRITICAL() interrupts()
+	#define MATRIXKEYPAD_SCAN_LOCK() do { } while(0)
+	#define MATRIXKEYPAD_SCAN_UNLOCK() do { } while(0)
+#endif
+
+/* Reads a field of a layout. With MATRIXKEYPAD_PROGMEM the layout is in the flash, like the mappings it points to */
+#if MATRIXKEYPAD_USE_PGM
+	#define MATRIXKEYPAD_LAYOUT_BYTE(layout, field) pgm_read_byte(&(layout)->field)
+	#define MATRIXKEYPAD_LAYOUT_PTR(layout, field) ((const void *)(uintptr_t)pgm_read_word(&(layout)->field))
+#else
+	#define MATRIXKEYPAD_LAYOUT_BYTE(layout, field) ((layout)->field)
+	#define MATRIXKEYPAD_LAYOUT_PTR(layout, field) ((const void *)(layout)->field)
+#endif
+
+/* Pin mappings, key mapping and dimensions of a keypad. With MATRIXKEYPAD_COMPACT they are read from its layout */
+#if MATRIXKEYPAD_COMPACT
+	#define MATRIXKEYPAD_ROWPINS(keypad) ((const uint8_t *)MATRIXKEYPAD_LAYOUT_PTR((keypad)->layout, rowPins))
+	#define MATRIXKEYPAD_COLPINS(keypad) ((const uint8_t *)MATRIXKEYPAD_LAYOUT_PTR((keypad)->layout, colPins))
+	#define MATRIXKEYPAD_KEYMAP(keypad) ((const char *)MATRIXKEYPAD_LAYOUT_PTR((keypad)->layout, keyMap))
+	#define MATRIXKEYPAD_ROWN(keypad) MATRIXKEYPAD_LAYOUT_BYTE((keypad)->layout, rown)
+	#define MATRIXKEYPAD_COLN(keypad) MATRIXKEYPAD_LAYOUT_BYTE((keypad)->layout, coln)
+#else
+	#define MATRIXKEYPAD_ROWPINS(keypad) ((keypad)->rowPins)
+	#define MATRIXKEYPAD_COLPINS(keypad) ((keypad)->colPins)
+	#define MATRIXKEYPAD_KEYMAP(keypad) ((keypad)->keyMap)
+	#define MATRIXKEYPAD_ROWN(keypad) ((keypad)->rown)
+	#define MATRIXKEYPAD_COLN(keypad) ((keypad)->coln)
+#endif
+
+/* Value saved by the scan for the key "i": its character or, with MATRIXKEYPAD_INDEX, the index plus one, so '\0' is still the "not detected" key */
+#if MATRIXKEYPAD_INDEX
+	#define MATRIXKEYPAD_ITEM(keypad, i) ((char)((i) + 1))
+#else
+	#define MATRIXKEYPAD_ITEM(keypad, i) MATRIXKEYPAD_KEY(MATRIXKEYPAD_KEYMAP(keypad), i)
+#endif
+
+/* Character of a value saved by the scan: the inverse of MATRIXKEYPAD_ITEM */
+#if MATRIXKEYPAD_INDEX
+	#define MATRIXKEYPAD_ITEM_KEY(keypad, item) MATRIXKEYPAD_KEY(MATRIXKEYPAD_KEYMAP(keypad), (uint8_t)(item) - 1)
+#else
+	#define MATRIXKEYPAD_ITEM_KEY(keypad, item) (item)
+#endif
+
+#if MATRIXKEYPAD_TIMER && defined(__AVR__) && defined(TIMER2_COMPA_vect)
+	#define MATRIXKEYPAD_USE_TIMER2 1
+#else
+	#define MATRIXKEYPAD_USE_TIMER2 0
+#endif
+
+#if MATRIXKEYPAD_USE_PORTS
+/* Drives a row pin. The pin must have been configured by MatrixKeypad_create */
+static inline void MatrixKeypad_writeRow (MatrixKeypad_t *keypad, uint8_t row, uint8_t level){
+	
+	volatile uint8_t *reg = keypad->rowPorts[row].reg;
+	uint8_t mask = keypad->rowPorts[row].mask;
+	uint8_t oldSREG = SREG; /* the read-modify-write must not be interrupted by an ISR that writes the same port */
+	
+	cli();
+	if(level == LOW) {
+		*reg &= ~mask;
+	}
+	else {
+		*reg |= mask;
+	}
+	SREG = oldSREG;
+}
+
+/* Returns the position of the single bit set in the mask */
+static uint8_t MatrixKeypad_bitIndex (uint8_t mask){
+	
+	uint8_t i = 0;
+	
+	while(mask > 1) {
+		mask >>= 1;
+		i++;
+	}
+	
+	return i;
+}
+
+/* Reads all the columns. Returns a word with the bit "col" set if the column "col" reads as LOW */
+static inline MatrixKeypad_cols_t MatrixKeypad_readCols (MatrixKeypad_t *keypad){
+	
+	MatrixKeypad_cols_t cols = 0;
+	uint8_t g, bit, value;
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) {
+		return keypad->transport->readCols(keypad->transport->context);
+	}
+#endif
+	if(keypad->colGroupn > 0) {
+		/* one load per port. The loop over the bits only runs when a key is pressed */
+		for(g = 0; g < keypad->colGroupn; g++) {
+			value = ~(*keypad->colGroups[g].reg) & keypad->colGroups[g].mask;
+			for(bit = 0; value != 0; bit++, value >>= 1) {
+				if(value & 1) {
+					cols |= (MatrixKeypad_cols_t)1 << keypad->colGroups[g].cols[bit];
+				}
+			}
+		}
+	}
+	else {
+		for(bit = 0; bit < MATRIXKEYPAD_COLN(keypad); bit++) {
+			if((*keypad->colPorts[bit].reg & keypad->colPorts[bit].mask) == 0) {
+				cols |= (MatrixKeypad_cols_t)1 << bit;
+			}
+		}
+	}
+	
+	return cols;
+}
+#elif MATRIXKEYPAD_MULTIKEY || MATRIXKEYPAD_TRANSPORT
+/* Reads all the columns. Returns a word with the bit "col" set if the column "col" reads as LOW */
+static inline MatrixKeypad_cols_t MatrixKeypad_readCols (MatrixKeypad_t *keypad){
+	
+	MatrixKeypad_cols_t cols = 0;
+	uint8_t col;
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) {
+		return keypad->transport->readCols(keypad->transport->context);
+	}
+#endif
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++) {
+		if(digitalRead(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col)) == LOW) {
+			cols |= (MatrixKeypad_cols_t)1 << col;
+		}
+	}
+	
+	return cols;
+}
+#endif
+
+/* Drives the row "row" to LOW and the row strobed before it to HIGH. The rows must be strobed in order, followed by MatrixKeypad_releaseRows of the last one */
+static inline void MatrixKeypad_selectRow (MatrixKeypad_t *keypad, uint8_t row){
+	
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t oldSREG;
+#endif
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) {
+		keypad->transport->selectRow(keypad->transport->context, row);
+		return;
+	}
+#endif
+#if MATRIXKEYPAD_USE_PORTS
+	if(keypad->rowReg != NULL) {
+		oldSREG = SREG;
+		cli();
+		*keypad->rowReg = (*keypad->rowReg | keypad->rowMask) & ~keypad->rowPorts[row].mask; /* releases the previous row and strobes the new one in a single write */
+		SREG = oldSREG;
+	}
+	else {
+		if(row > 0) {
+			MatrixKeypad_writeRow(keypad, row - 1, HIGH);
+		}
+		MatrixKeypad_writeRow(keypad, row, LOW);
+	}
+#else
+	if(row > 0) {
+		digitalWrite(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), row - 1), HIGH);
+	}
+	digitalWrite(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), row), LOW);
+#endif
+}
+
+/* Waits for the columns to settle after a row is strobed. Long cables need some time to charge */
+static inline void MatrixKeypad_settle (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_SETTLE
+	if(keypad->settleTime != 0) { /* only the keypads that need it pay for the delay */
+		delayMicroseconds(keypad->settleTime);
+	}
+#else
+	(void)keypad;
+#endif
+}
+
+/* Drives the last strobed row, "row", back to HIGH */
+static inline void MatrixKeypad_releaseRows (MatrixKeypad_t *keypad, uint8_t row){
+	
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t oldSREG;
+#endif
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) {
+		keypad->transport->releaseRows(keypad->transport->context);
+		return;
+	}
+#endif
+#if MATRIXKEYPAD_USE_PORTS
+	if(keypad->rowReg != NULL) {
+		oldSREG = SREG;
+		cli();
+		*keypad->rowReg |= keypad->rowMask;
+		SREG = oldSREG;
+	}
+	else {
+		MatrixKeypad_writeRow(keypad, row, HIGH);
+	}
+#else
+	digitalWrite(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), row), HIGH);
+#endif
+}
+
+#if MATRIXKEYPAD_INTERRUPTS || MATRIXKEYPAD_EARLY_EXIT
+/* Drives all rows to the same level */
+static void MatrixKeypad_writeRows (MatrixKeypad_t *keypad, uint8_t level){
+	
+	uint8_t row;
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t oldSREG;
+	
+	if(keypad->rowReg != NULL) {
+		oldSREG = SREG;
+		cli();
+		if(level == LOW) {
+			*keypad->rowReg &= ~keypad->rowMask;
+		}
+		else {
+			*keypad->rowReg |= keypad->rowMask;
+		}
+		SREG = oldSREG;
+		return;
+	}
+	for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+		MatrixKeypad_writeRow(keypad, row, level);
+	}
+#else
+	for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+		digitalWrite(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), row), level);
+	}
+#endif
+}
+
+/* Returns 1 if any column reads as LOW */
+static uint8_t MatrixKeypad_anyColLow (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_USE_PORTS
+	return MatrixKeypad_readCols(keypad) != 0;
+#else
+	uint8_t col;
+	
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		if(digitalRead(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col)) == LOW) {
+			return 1;
+		}
+	}
+	return 0;
+#endif
+}
+
+#endif
+
+#if MATRIXKEYPAD_USE_PROBE
+/* Drives all rows LOW together and reads the columns once. Returns 1 if any key is pressed.
+ * With a transport, asks the transport instead. Returns 1 if it doesn't know
+ */
+static inline uint8_t MatrixKeypad_probe (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_EARLY_EXIT
+	uint8_t any;
+#endif
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) {
+		return keypad->transport->probe == NULL || keypad->transport->probe(keypad->transport->context);
+	}
+#endif
+#if MATRIXKEYPAD_EARLY_EXIT
+	MatrixKeypad_writeRows(keypad, LOW);
+	MatrixKeypad_settle(keypad);
+	any = MatrixKeypad_anyColLow(keypad);
+	MatrixKeypad_writeRows(keypad, HIGH);
+	
+	return any;
+#else
+	(void)keypad;
+	return 1;
+#endif
+}
+#endif
+
+#if MATRIXKEYPAD_INTERRUPTS
+static MatrixKeypad_t * volatile MatrixKeypad_idleList = NULL; /* keypads in idle mode. Walked by MatrixKeypad_wakeFromISR */
+
+void MatrixKeypad_wakeFromISR (void){
+	
+	MatrixKeypad_t *keypad;
+#if MATRIXKEYPAD_USE_NOTIFY
+	BaseType_t woken = pdFALSE;
+#endif
+	
+	/* the ISR doesn't know which keypad fired. A spurious wake only costs one scan */
+	for(keypad = MatrixKeypad_idleList; keypad != NULL; keypad = keypad->nextIdle) {
+		if(keypad->armed) {
+			keypad->wake = 1;
+#if MATRIXKEYPAD_USE_NOTIFY
+			if(keypad->waitTask != NULL) { /* unblocks the task waiting for a key */
+				vTaskNotifyGiveFromISR((TaskHandle_t)keypad->waitTask, &woken);
+			}
+#endif
+		}
+	}
+#if MATRIXKEYPAD_USE_NOTIFY
+	if(woken == pdTRUE) {
+		portYIELD_FROM_ISR();
+	}
+#endif
+}
+
+#if MATRIXKEYPAD_USE_PCINT
+	#if defined(PCINT0_vect)
+		ISR(PCINT0_vect) { MatrixKeypad_wakeFromISR(); }
+	#endif
+	#if defined(PCINT1_vect)
+		ISR(PCINT1_vect) { MatrixKeypad_wakeFromISR(); }
+	#endif
+	#if defined(PCINT2_vect)
+		ISR(PCINT2_vect) { MatrixKeypad_wakeFromISR(); }
+	#endif
+	#if defined(PCINT3_vect)
+		ISR(PCINT3_vect) { MatrixKeypad_wakeFromISR(); }
+	#endif
+#endif
+
+/* Enables or disables the interrupts of the column pins. Uses the external interrupts when the pin has one, otherwise the pin change interrupts (AVR only) */
+static void MatrixKeypad_colInterrupts (MatrixKeypad_t *keypad, uint8_t enable){
+	
+	uint8_t col, pin;
+	int irq;
+	
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		irq = digitalPinToInterrupt(pin);
+		if(irq != NOT_AN_INTERRUPT) {
+			if(enable) {
+				attachInterrupt(irq, MatrixKeypad_wakeFromISR, FALLING);
+			}
+			else {
+				detachInterrupt(irq);
+			}
+		}
+#if MATRIXKEYPAD_USE_PCINT
+		else if(digitalPinToPCICR(pin) != 0) {
+			if(enable) {
+				*digitalPinToPCMSK(pin) |= (1 << digitalPinToPCMSKbit(pin));
+				*digitalPinToPCICR(pin) |= (1 << digitalPinToPCICRbit(pin));
+			}
+			else {
+				*digitalPinToPCMSK(pin) &= ~(1 << digitalPinToPCMSKbit(pin));
+			}
+		}
+#endif
+	}
+}
+
+/* Drives all rows LOW, so any keypress pulls its column LOW and fires the interrupt */
+static void MatrixKeypad_arm (MatrixKeypad_t *keypad){
+	
+	keypad->wake = 0;
+	MatrixKeypad_writeRows(keypad, LOW);
+	MatrixKeypad_colInterrupts(keypad, 1);
+	keypad->armed = 1;
+	if(MatrixKeypad_anyColLow(keypad)) { /* a key pressed while arming wouldn't fire the edge */
+		keypad->wake = 1;
+	}
+}
+
+/* Restores the rows to HIGH so the keypad can be scanned */
+static void MatrixKeypad_disarm (MatrixKeypad_t *keypad){
+	
+	keypad->armed = 0;
+	MatrixKeypad_colInterrupts(keypad, 0);
+	MatrixKeypad_writeRows(keypad, HIGH);
+}
+
+/* Removes the keypad from the list of keypads in idle mode */
+static void MatrixKeypad_unlinkIdle (MatrixKeypad_t *keypad){
+	
+	MatrixKeypad_t * volatile *link;
+	
+	noInterrupts();
+	for(link = &MatrixKeypad_idleList; *link != NULL; link = &(*link)->nextIdle) {
+		if(*link == keypad) {
+			*link = keypad->nextIdle;
+			break;
+		}
+	}
+	interrupts();
+}
+
+void MatrixKeypad_setIdleMode (MatrixKeypad_t *keypad, uint8_t enable){
+	
+	MatrixKeypad_t *item;
+	
+	if(keypad == NULL || keypad->idleMode == (enable != 0)) {
+		return;
+	}
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) { /* the interrupts need the column pins */
+		return;
+	}
+#endif
+	
+	if(enable) {
+		for(item = MatrixKeypad_idleList; item != NULL && item != keypad; item = item->nextIdle);
+		if(item == NULL) {
+			noInterrupts();
+			keypad->armed = 0;
+			keypad->nextIdle = MatrixKeypad_idleList;
+			MatrixKeypad_idleList = keypad;
+			interrupts();
+		}
+		keypad->idleMode = 1;
+		if(keypad->lastKey == '\0') { /* otherwise arms when the key is released */
+			MatrixKeypad_arm(keypad);
+		}
+	}
+	else {
+		if(keypad->armed) {
+			MatrixKeypad_disarm(keypad);
+		}
+		MatrixKeypad_unlinkIdle(keypad);
+		keypad->idleMode = 0;
+	}
+}
+
+uint8_t MatrixKeypad_isIdle (MatrixKeypad_t *keypad){
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+	
+	return keypad->armed && !keypad->wake;
+}
+#endif
+
+#if !MATRIXKEYPAD_COMPACT
+MatrixKeypad_t *MatrixKeypad_create (const char *keymap, const uint8_t *rowPins, const uint8_t *colPins, uint8_t rown, uint8_t coln){
+	
+	MatrixKeypad_t *keypad;
+
+	keypad = malloc(sizeof(MatrixKeypad_t));
+	if(keypad == NULL) {
+		return NULL;
+	}
+	
+	if(MatrixKeypad_init(keypad, keymap, rowPins, colPins, rown, coln) == NULL) {
+		free(keypad);
+		return NULL;
+	}
+	keypad->allocated = 1;
+    
+	return keypad;
+}
+
+MatrixKeypad_t *MatrixKeypad_init (MatrixKeypad_t *keypad, const char *keymap, const uint8_t *rowPins, const uint8_t *colPins, uint8_t rown, uint8_t coln){
+	
+	if(keypad == NULL) {
+		return NULL;
+	}
+
+	keypad->rown = rown;
+	keypad->coln = coln;
+	keypad->rowPins = rowPins;
+	keypad->colPins = colPins;
+	keypad->keyMap = keymap;
+	keypad->allocated = 0;
+#if MATRIXKEYPAD_TRANSPORT
+	keypad->transport = NULL;
+#endif
+	
+	if(!MatrixKeypad_begin(keypad)) {
+		return NULL;
+	}
+    
+	return keypad;
+}
+#endif
+
+MatrixKeypad_t *MatrixKeypad_initLayout (MatrixKeypad_t *keypad, const MatrixKeypad_layout_t *layout){
+	
+	if(keypad == NULL || layout == NULL) {
+		return NULL;
+	}
+
+#if MATRIXKEYPAD_COMPACT
+	keypad->layout = layout;
+#if MATRIXKEYPAD_TRANSPORT
+	keypad->transport = NULL;
+#endif
+	
+	if(!MatrixKeypad_begin(keypad)) {
+		return NULL;
+	}
+    
+	return keypad;
+#else
+	return MatrixKeypad_init(keypad, (const char *)MATRIXKEYPAD_LAYOUT_PTR(layout, keyMap), (const uint8_t *)MATRIXKEYPAD_LAYOUT_PTR(layout, rowPins),
+		(const uint8_t *)MATRIXKEYPAD_LAYOUT_PTR(layout, colPins), MATRIXKEYPAD_LAYOUT_BYTE(layout, rown), MATRIXKEYPAD_LAYOUT_BYTE(layout, coln));
+#endif
+}
+
+#if MATRIXKEYPAD_TRANSPORT && !MATRIXKEYPAD_COMPACT
+MatrixKeypad_t *MatrixKeypad_initTransport (MatrixKeypad_t *keypad, const char *keymap, const MatrixKeypad_transport_t *transport, uint8_t rown, uint8_t coln){
+	
+	if(keypad == NULL || transport == NULL) {
+		return NULL;
+	}
+
+	keypad->rown = rown;
+	keypad->coln = coln;
+	keypad->rowPins = NULL; /* the pins belong to the transport */
+	keypad->colPins = NULL;
+	keypad->keyMap = keymap;
+	keypad->allocated = 0;
+	keypad->transport = transport;
+	
+	if(!MatrixKeypad_begin(keypad)) {
+		return NULL;
+	}
+    
+	return keypad;
+}
+#endif
+
+uint8_t MatrixKeypad_begin (MatrixKeypad_t *keypad){
+	
+	uint8_t i;
+#if MATRIXKEYPAD_USE_PORTS || MATRIXKEYPAD_DEBOUNCE
+	uint8_t g;
+#endif
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+#if MATRIXKEYPAD_COMPACT
+	if(keypad->layout == NULL) {
+		return 0;
+	}
+#endif
+
+#if MATRIXKEYPAD_USE_PORTS || MATRIXKEYPAD_MULTIKEY
+	if(MATRIXKEYPAD_ROWN(keypad) > MATRIXKEYPAD_MAX_ROWS || MATRIXKEYPAD_COLN(keypad) > MATRIXKEYPAD_MAX_COLS) { /* the registers and the key states are kept in fixed size arrays */
+		return 0;
+	}
+#endif
+#if MATRIXKEYPAD_INDEX
+	if((uint16_t)MATRIXKEYPAD_ROWN(keypad) * MATRIXKEYPAD_COLN(keypad) > 255) { /* the index plus one is saved in a byte */
+		return 0;
+	}
+#endif
+	
+	keypad->lastKey = '\0';
+	keypad->buffer = '\0';
+#if MATRIXKEYPAD_MULTIKEY
+	for(i = 0; i < MATRIXKEYPAD_ROWN(keypad); i++){
+		keypad->raw[i] = 0;
+		keypad->state[i] = 0;
+		keypad->changes[i] = 0;
+#if MATRIXKEYPAD_DEBOUNCE
+		for(g = 0; g < MATRIXKEYPAD_DEBOUNCE_BITS; g++){
+			keypad->counters[g][i] = 0;
+		}
+#endif
+	}
+#endif
+#if MATRIXKEYPAD_DEBOUNCE
+	keypad->debounceCount = MATRIXKEYPAD_DEBOUNCE_COUNT;
+#endif
+#if MATRIXKEYPAD_GHOST
+	keypad->ghosted = 0;
+#endif
+#if MATRIXKEYPAD_REPEAT
+	keypad->repeatDelay = MATRIXKEYPAD_REPEAT_DELAY;
+	keypad->repeatInterval = MATRIXKEYPAD_REPEAT_INTERVAL;
+	keypad->holdTime = MATRIXKEYPAD_HOLD_TIME;
+	keypad->repeatState = 0;
+#endif
+#if MATRIXKEYPAD_USE_STEP
+	keypad->scanRow = 0;
+	keypad->frameKey = '\0';
+	keypad->scanIndex = 0;
+#endif
+#if MATRIXKEYPAD_INDEX
+	keypad->lookup = NULL;
+	keypad->lookupSize = 0;
+#endif
+#if MATRIXKEYPAD_TIMER
+	keypad->timed = 0;
+#endif
+#if MATRIXKEYPAD_SETTLE
+	keypad->settleTime = MATRIXKEYPAD_SETTLE_TIME;
+#endif
+#if MATRIXKEYPAD_ADAPTIVE
+	keypad->activeInterval = MATRIXKEYPAD_ACTIVE_INTERVAL;
+	keypad->idleInterval = MATRIXKEYPAD_IDLE_INTERVAL;
+	keypad->lastScan = millis() - MATRIXKEYPAD_IDLE_INTERVAL; /* the first poll scans the keypad */
+	keypad->active = 0;
+#endif
+#if MATRIXKEYPAD_USE_QUEUE
+	keypad->queueHead = 0;
+	keypad->queueTail = 0;
+	keypad->overflows = 0;
+#elif MATRIXKEYPAD_USE_SEQ
+	keypad->bufferSeq = 0;
+	keypad->bufferAck = 0;
+#endif
+#if MATRIXKEYPAD_CALLBACKS
+	keypad->onPress = NULL;
+	keypad->onRelease = NULL;
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+	keypad->pending = 0;
+#if MATRIXKEYPAD_MULTIKEY
+	for(i = 0; i < MATRIXKEYPAD_ROWN(keypad); i++){
+		keypad->pressLatch[i] = 0;
+		keypad->reported[i] = 0;
+	}
+#else
+	keypad->pressLatch = '\0';
+	keypad->reported = '\0';
+#endif
+#endif
+#endif
+#if MATRIXKEYPAD_STATS
+	MatrixKeypad_resetStats(keypad);
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+	keypad->idleMode = 0;
+	keypad->armed = 0;
+	keypad->wake = 0;
+#if MATRIXKEYPAD_USE_NOTIFY
+	keypad->waitTask = NULL;
+#endif
+#endif
+#if MATRIXKEYPAD_USE_RTOS
+	keypad->task = NULL;
+	keypad->taskRun = 0;
+	keypad->taskDone = 0;
+	keypad->subscribern = 0;
+#endif
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) {
+		if(MATRIXKEYPAD_ROWN(keypad) > MATRIXKEYPAD_MAX_ROWS || MATRIXKEYPAD_COLN(keypad) > MATRIXKEYPAD_MAX_COLS) { /* a frame is a column word for each row */
+			return 0;
+		}
+		if((keypad->transport->rown != 0 && keypad->transport->rown != MATRIXKEYPAD_ROWN(keypad)) || (keypad->transport->coln != 0 && keypad->transport->coln != MATRIXKEYPAD_COLN(keypad))) {
+			return 0; /* the keypad doesn't match the hardware of the backend */
+		}
+		keypad->transport->begin(keypad->transport->context);
+		return 1;
+	}
+#endif
+	
+	/* How the hardware works
+	 * 
+	 * The keypad is a matrix which each row and column is a wire. All wires are disconnected from each other.
+	 * When a button is pressed the corresponding row and column wires are shorted.
+	 * To detect that, the rows are set as outputs and held high and the columns are set as inputs with pullup resistors.
+	 * To scan a row, the row is set to low. If a key is pressed, the corresponding column will read as low. 
+	 */
+	for(i = 0; i < MATRIXKEYPAD_ROWN(keypad); i++){
+		pinMode(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), i), OUTPUT);
+		digitalWrite(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), i), HIGH);
+#if MATRIXKEYPAD_USE_PORTS
+		/* resolves the pin to its port only once. digitalWrite does this lookup on every call */
+		keypad->rowPorts[i].reg = portOutputRegister(digitalPinToPort(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), i)));
+		keypad->rowPorts[i].mask = digitalPinToBitMask(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypad), i));
+#endif
+	}
+	for(i = 0; i < MATRIXKEYPAD_COLN(keypad); i++){
+		pinMode(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), i), INPUT_PULLUP);
+#if MATRIXKEYPAD_USE_PORTS
+		keypad->colPorts[i].reg = portInputRegister(digitalPinToPort(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), i)));
+		keypad->colPorts[i].mask = digitalPinToBitMask(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), i));
+#endif
+	}
+	
+#if MATRIXKEYPAD_USE_PORTS
+	/* if all rows are on the same port, a row strobe is a single masked write */
+	keypad->rowReg = keypad->rowPorts[0].reg;
+	keypad->rowMask = 0;
+	for(i = 0; i < MATRIXKEYPAD_ROWN(keypad); i++){
+		if(keypad->rowPorts[i].reg != keypad->rowReg) {
+			keypad->rowReg = NULL;
+			break;
+		}
+		keypad->rowMask |= keypad->rowPorts[i].mask;
+	}
+	
+	/* groups the columns by port, so the columns of a port are read by a single load */
+	keypad->colGroupn = 0;
+	for(i = 0; i < MATRIXKEYPAD_COLN(keypad); i++){
+		for(g = 0; g < keypad->colGroupn && keypad->colGroups[g].reg != keypad->colPorts[i].reg; g++);
+		if(g == keypad->colGroupn) {
+			if(g == MATRIXKEYPAD_PORT_GROUPS) { /* too many ports, reads each column pin instead */
+				keypad->colGroupn = 0;
+				break;
+			}
+			keypad->colGroups[g].reg = keypad->colPorts[i].reg;
+			keypad->colGroups[g].mask = 0;
+			keypad->colGroupn++;
+		}
+		keypad->colGroups[g].mask |= keypad->colPorts[i].mask;
+		keypad->colGroups[g].cols[MatrixKeypad_bitIndex(keypad->colPorts[i].mask)] = i;
+	}
+#endif
+	
+	return 1;
+}
+
+#if !MATRIXKEYPAD_COMPACT
+void MatrixKeypad_setKeymap (MatrixKeypad_t *keypad, const char *keymap){
+	
+	if(keypad == NULL || keymap == NULL) {
+		return;
+	}
+	
+	MATRIXKEYPAD_ENTER_CRITICAL(); /* the pointer takes two stores on AVR and the timer ISR can be scanning */
+	keypad->keyMap = keymap;
+	MATRIXKEYPAD_EXIT_CRITICAL();
+}
+#endif
+
+void MatrixKeypad_destroy (MatrixKeypad_t *keypad){
+
+#if MATRIXKEYPAD_USE_RTOS
+	MatrixKeypad_stopTask(keypad);
+#endif
+#if MATRIXKEYPAD_TIMER
+	MatrixKeypad_stopTimer(keypad);
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+	MatrixKeypad_setIdleMode(keypad, 0); /* the ISR must not see the released memory */
+#endif
+#if !MATRIXKEYPAD_COMPACT
+	if(keypad != NULL && keypad->allocated) { /* the other keypads belong to the caller */
+		free(keypad);
+	}
+#else
+	(void)keypad; /* the compact keypads are never allocated */
+#endif
+}
+
+#if !MATRIXKEYPAD_MULTIKEY
+/* Reads the columns of the strobed row, whose first key has the index "index". Returns the key of the last column that reads LOW or "key" if none does */
+static inline char MatrixKeypad_readRowKey (MatrixKeypad_t *keypad, uint16_t index, char key){
+	
+	uint8_t col;
+#if MATRIXKEYPAD_USE_PORTS
+	MatrixKeypad_cols_t cols;
+	
+	cols = MatrixKeypad_readCols(keypad);
+	for(col = 0; cols != 0; col++, cols >>= 1){
+		if(cols & 1) {
+			key = MATRIXKEYPAD_ITEM(keypad, index + col); /* imagine as keyMap[row][col] */
+		}
+	}
+#else
+#if MATRIXKEYPAD_TRANSPORT
+	MatrixKeypad_cols_t cols;
+	
+	if(keypad->transport != NULL) {
+		cols = MatrixKeypad_readCols(keypad);
+		for(col = 0; cols != 0; col++, cols >>= 1){
+			if(cols & 1) {
+				key = MATRIXKEYPAD_ITEM(keypad, index + col); /* imagine as keyMap[row][col] */
+			}
+		}
+		return key;
+	}
+#endif
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		if(digitalRead(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col)) == LOW) {
+			key = MATRIXKEYPAD_ITEM(keypad, index + col); /* imagine as keyMap[row][col] */
+		}
+	}
+#endif
+	
+	return key;
+}
+#endif
+
+/* Returns 1 if the keypad is idle and the scan must be skipped */
+static inline uint8_t MatrixKeypad_skipIdle (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_INTERRUPTS
+	if(keypad->armed) {
+		if(!keypad->wake) { /* no edge on the columns since the last scan, so no key is pressed */
+			return 1;
+		}
+		MatrixKeypad_disarm(keypad);
+	}
+#else
+	(void)keypad;
+#endif
+	
+	return 0;
+}
+
+#if MATRIXKEYPAD_STATS
+/* Counts a completed frame. "start" is the micros() at the start of the current call, the previous calls of a stepped frame are in "statsBusy" */
+static void MatrixKeypad_statsFrame (MatrixKeypad_t *keypad, uint32_t start){
+	
+	MatrixKeypad_stats_t *stats = &keypad->stats;
+	uint32_t time = keypad->statsBusy + (micros() - start);
+	
+	MATRIXKEYPAD_SCAN_LOCK();
+	if(stats->scans != 0 && keypad->statsStart - keypad->statsLast > stats->maxGap) {
+		stats->maxGap = keypad->statsStart - keypad->statsLast;
+	}
+	keypad->statsLast = keypad->statsStart;
+	stats->scans++;
+	stats->totalTime += time;
+	if(time > stats->worstTime) {
+		stats->worstTime = time;
+	}
+	MATRIXKEYPAD_SCAN_UNLOCK();
+}
+
+/* Counts the read of a key detected at "time" (lower 16 bits of millis()) in the latency histogram. Only called by the consumer */
+static void MatrixKeypad_statsLatency (MatrixKeypad_t *keypad, uint16_t time){
+	
+	uint16_t elapsed = (uint16_t)millis() - time;
+	uint8_t bucket = 0;
+	
+	while(elapsed != 0 && bucket < MATRIXKEYPAD_STATS_BUCKETS - 1) { /* the bucket is the bit length of the latency */
+		elapsed >>= 1;
+		bucket++;
+	}
+	if(keypad->stats.latency[bucket] != 0xFFFF) {
+		keypad->stats.latency[bucket]++;
+	}
+}
+#endif
+
+#if MATRIXKEYPAD_EVENTS
+/* Adds an event to the queue. Only the producer (the scan) writes "queueHead" and only the consumer (MatrixKeypad_getEvent, MatrixKeypad_getKey) writes "queueTail" */
+static void MatrixKeypad_pushEvent (MatrixKeypad_t *keypad, uint8_t key, uint8_t type, uint16_t time){
+	
+	uint8_t head = keypad->queueHead;
+	MatrixKeypad_event_t *event;
+	
+	if((uint8_t)(head - keypad->queueTail) >= MATRIXKEYPAD_QUEUE_SIZE) { /* full. Keeps the older events, they happened first */
+		keypad->overflows++;
+#if MATRIXKEYPAD_STATS
+		keypad->stats.drops++;
+#endif
+		return;
+	}
+	event = &keypad->queue[head & (MATRIXKEYPAD_QUEUE_SIZE - 1)];
+	event->key = key;
+	event->type = type;
+	event->time = time;
+	keypad->queueHead = head + 1; /* publishes the event after writing it */
+}
+
+/* Discards the events at the head of the queue that aren't key presses or repeats. Only called by the consumer */
+static void MatrixKeypad_skipToPress (MatrixKeypad_t *keypad){
+	
+	uint8_t tail = keypad->queueTail;
+	uint8_t type;
+	
+	while(tail != keypad->queueHead) {
+		type = keypad->queue[tail & (MATRIXKEYPAD_QUEUE_SIZE - 1)].type;
+#if MATRIXKEYPAD_REPEAT
+		if(type == MATRIXKEYPAD_EVENT_PRESS || type == MATRIXKEYPAD_EVENT_REPEAT) {
+#else
+		if(type == MATRIXKEYPAD_EVENT_PRESS) {
+#endif
+			break;
+		}
+		tail++;
+	}
+	keypad->queueTail = tail;
+}
+#else
+#if MATRIXKEYPAD_USE_QUEUE
+/* Adds a key to the queue. Only the producer (the scan) writes "queueHead" and only the consumer (MatrixKeypad_getKey) writes "queueTail" */
+static void MatrixKeypad_push (MatrixKeypad_t *keypad, char key){
+	
+	uint8_t head = keypad->queueHead;
+	
+	if((uint8_t)(head - keypad->queueTail) >= MATRIXKEYPAD_QUEUE_SIZE) { /* full. Keeps the older keys, they were typed first */
+		keypad->overflows++;
+#if MATRIXKEYPAD_STATS
+		keypad->stats.drops++;
+#endif
+		return;
+	}
+	keypad->queue[head & (MATRIXKEYPAD_QUEUE_SIZE - 1)] = key;
+#if MATRIXKEYPAD_STATS
+	keypad->queueTime[head & (MATRIXKEYPAD_QUEUE_SIZE - 1)] = (uint16_t)millis();
+#endif
+	keypad->queueHead = head + 1; /* publishes the key after writing it */
+}
+#endif
+
+/* Makes a key available to MatrixKeypad_getKey */
+static inline void MatrixKeypad_deliver (MatrixKeypad_t *keypad, char key){
+	
+#if MATRIXKEYPAD_USE_QUEUE
+	MatrixKeypad_push(keypad, key);
+#else
+#if MATRIXKEYPAD_STATS
+#if MATRIXKEYPAD_USE_SEQ
+	if(keypad->bufferSeq != keypad->bufferAck) { /* the previous key wasn't read */
+#else
+	if(keypad->buffer != '\0') {
+#endif
+		keypad->stats.overwrites++;
+	}
+	keypad->bufferTime = (uint16_t)millis();
+#endif
+	keypad->buffer = key;
+#if MATRIXKEYPAD_USE_SEQ
+	keypad->bufferSeq++; /* publishes the key after writing it */
+#endif
+#endif
+}
+#endif
+
+#if MATRIXKEYPAD_DEBOUNCE
+/* Debounces a row of the frame with vertical counters. Each key has a counter of MATRIXKEYPAD_DEBOUNCE_BITS bits, stored one bit per word,
+ * so the counters of all keys of the row are updated at once with a few bitwise operations.
+ * The counter of a key counts the consecutive frames in which the raw reading differs from the debounced state. When it reaches
+ * "debounceCount", the debounced state of the key toggles. A reading equal to the debounced state resets the counter, so a bounce restarts the count.
+ * Returns the new debounced state of the row.
+ */
+static inline MatrixKeypad_cols_t MatrixKeypad_debounce (MatrixKeypad_t *keypad, uint8_t row){
+	
+	MatrixKeypad_cols_t delta, carry, next, reached;
+	uint8_t bit;
+	
+	delta = keypad->raw[row] ^ keypad->state[row]; /* keys that read different from the debounced state */
+	
+	/* increments the counters of the keys in "delta" and clears the others */
+	carry = delta;
+	for(bit = 0; bit < MATRIXKEYPAD_DEBOUNCE_BITS; bit++){
+		next = keypad->counters[bit][row] & carry;
+		keypad->counters[bit][row] = (keypad->counters[bit][row] ^ carry) & delta;
+		carry = next;
+	}
+	
+	/* keys whose counter is equal to "debounceCount" */
+	reached = delta;
+	for(bit = 0; bit < MATRIXKEYPAD_DEBOUNCE_BITS; bit++){
+		if((keypad->debounceCount >> bit) & 1) {
+			reached &= keypad->counters[bit][row];
+		}
+		else {
+			reached &= ~keypad->counters[bit][row];
+		}
+	}
+	for(bit = 0; bit < MATRIXKEYPAD_DEBOUNCE_BITS; bit++){
+		keypad->counters[bit][row] &= ~reached;
+	}
+	
+	return keypad->state[row] ^ reached;
+}
+#endif
+
+#if MATRIXKEYPAD_GHOST
+/* Finds the ghost keys in "raw". Two rows that share two or more pressed columns form a rectangle, and any of its corners can be a ghost.
+ * The keys of the shared columns of both rows keep their previous state, so the frame neither presses nor releases them.
+ * Each pair of rows costs one AND. Returns 1 if the frame has ambiguous keys
+ */
+static uint8_t MatrixKeypad_deghost (MatrixKeypad_t *keypad){
+	
+	MatrixKeypad_cols_t ambiguous[MATRIXKEYPAD_MAX_ROWS], common;
+	uint8_t i, j, ghosted = 0;
+	
+	for(i = 0; i < MATRIXKEYPAD_ROWN(keypad); i++){
+		ambiguous[i] = 0;
+	}
+	
+	for(i = 0; i + 1 < MATRIXKEYPAD_ROWN(keypad); i++){
+		if((keypad->raw[i] & (keypad->raw[i] - 1)) == 0) { /* a row with less than two keys can't be in a rectangle */
+			continue;
+		}
+		for(j = i + 1; j < MATRIXKEYPAD_ROWN(keypad); j++){
+			common = keypad->raw[i] & keypad->raw[j];
+			if(common & (common - 1)) { /* two or more bits set */
+				ambiguous[i] |= common;
+				ambiguous[j] |= common;
+				ghosted = 1;
+			}
+		}
+	}
+	
+	if(ghosted) {
+		for(i = 0; i < MATRIXKEYPAD_ROWN(keypad); i++){
+			keypad->raw[i] = (keypad->raw[i] & ~ambiguous[i]) | (keypad->state[i] & ambiguous[i]);
+		}
+	}
+	
+	return ghosted;
+}
+#endif
+
+#if MATRIXKEYPAD_CALLBACKS && MATRIXKEYPAD_MULTIKEY
+/* Calls the callback of each key of a row whose bit is set in "changed": "onPress" if its bit in "cols" is set, "onRelease" otherwise.
+ * "index" is the index of the first key of the row */
+static void MatrixKeypad_notify (MatrixKeypad_t *keypad, uint16_t index, MatrixKeypad_cols_t changed, MatrixKeypad_cols_t cols){
+	
+	MatrixKeypad_callback_t callback;
+	
+	for(; changed != 0; index++, changed >>= 1, cols >>= 1){
+		if(changed & 1) {
+			callback = (cols & 1) ? keypad->onPress : keypad->onRelease;
+			if(callback != NULL) {
+				callback(keypad, MATRIXKEYPAD_KEY(MATRIXKEYPAD_KEYMAP(keypad), index));
+			}
+		}
+	}
+}
+#endif
+
+#if MATRIXKEYPAD_MULTIKEY
+#if MATRIXKEYPAD_REPEAT
+/* Adds the repeat and hold events of the held key at the frame time "time". One timer serves all keys, because only the last key pressed repeats */
+static void MatrixKeypad_repeat (MatrixKeypad_t *keypad, uint16_t time){
+	
+	if(keypad->repeatState == 1 && keypad->holdTime != 0 && (uint16_t)(time - keypad->repeatStart) >= keypad->holdTime) {
+		MatrixKeypad_pushEvent(keypad, keypad->repeatKey, MATRIXKEYPAD_EVENT_HOLD, time);
+		keypad->repeatState = 2;
+	}
+	if(keypad->repeatDelay != 0 && keypad->repeatInterval != 0 && (int16_t)(time - keypad->repeatNext) >= 0) {
+		MatrixKeypad_pushEvent(keypad, keypad->repeatKey, MATRIXKEYPAD_EVENT_REPEAT, time);
+		keypad->repeatNext += keypad->repeatInterval;
+		if((int16_t)(time - keypad->repeatNext) >= 0) { /* the scan is slower than the repeat, doesn't queue a burst of repeats */
+			keypad->repeatNext = time + keypad->repeatInterval;
+		}
+	}
+}
+#endif
+
+/* Compares the frame in "raw" with the previous one. Each key whose bit went from 0 to 1 is delivered as a keypress.
+ * With MATRIXKEYPAD_EVENTS, each key whose bit changed is queued as a press or release event */
+static void MatrixKeypad_processFrame (MatrixKeypad_t *keypad){
+	
+	uint8_t row, col;
+	uint16_t index; /* MULTIKEY allows more than 256 keys without MATRIXKEYPAD_EVENTS */
+	MatrixKeypad_cols_t cols, changed, any = 0;
+#if MATRIXKEYPAD_EVENTS
+	uint16_t time = 0;
+	uint8_t timed = 0;
+#else
+	MatrixKeypad_cols_t pressed;
+#endif
+	
+#if MATRIXKEYPAD_GHOST
+	keypad->ghosted = MatrixKeypad_deghost(keypad);
+#endif
+	for(row = 0, index = 0; row < MATRIXKEYPAD_ROWN(keypad); row++, index += MATRIXKEYPAD_COLN(keypad)){
+#if MATRIXKEYPAD_DEBOUNCE
+		cols = MatrixKeypad_debounce(keypad, row);
+		any |= keypad->raw[row]; /* doesn't go idle while a change is being integrated */
+#else
+		cols = keypad->raw[row];
+#endif
+		changed = cols ^ keypad->state[row]; /* the whole row is compared at once */
+		keypad->changes[row] = changed;
+		keypad->state[row] = cols;
+		any |= cols;
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+		if(changed != 0) {
+			MATRIXKEYPAD_SCAN_LOCK();
+			keypad->pressLatch[row] |= changed & cols; /* the releases are found by MatrixKeypad_dispatch from "state" */
+			keypad->pending = 1;
+			MATRIXKEYPAD_SCAN_UNLOCK();
+		}
+#elif MATRIXKEYPAD_CALLBACKS
+		if(changed != 0) {
+			MatrixKeypad_notify(keypad, index, changed, cols);
+		}
+#endif
+		
+#if MATRIXKEYPAD_EVENTS
+		if(changed != 0 && !timed) { /* the clock is read once per frame and only if a key changed */
+			time = (uint16_t)millis();
+			timed = 1;
+		}
+		for(col = 0; changed != 0; col++, changed >>= 1){
+			if(changed & 1) {
+				if((cols >> col) & 1) {
+					keypad->lastKey = MATRIXKEYPAD_ITEM(keypad, index + col);
+					MatrixKeypad_pushEvent(keypad, index + col, MATRIXKEYPAD_EVENT_PRESS, time);
+#if MATRIXKEYPAD_REPEAT
+					keypad->repeatKey = index + col; /* the new key replaces the one that was repeating */
+					keypad->repeatStart = time;
+					keypad->repeatNext = time + keypad->repeatDelay;
+					keypad->repeatState = 1;
+#endif
+				}
+				else {
+					MatrixKeypad_pushEvent(keypad, index + col, MATRIXKEYPAD_EVENT_RELEASE, time);
+#if MATRIXKEYPAD_REPEAT
+					if(keypad->repeatKey == index + col) {
+						keypad->repeatState = 0;
+					}
+#endif
+				}
+			}
+		}
+#else
+		pressed = changed & cols;
+		for(col = 0; pressed != 0; col++, pressed >>= 1){
+			if(pressed & 1) {
+				keypad->lastKey = MATRIXKEYPAD_ITEM(keypad, index + col);
+				MatrixKeypad_deliver(keypad, keypad->lastKey);
+			}
+		}
+#endif
+	}
+	
+#if MATRIXKEYPAD_REPEAT
+	if(keypad->repeatState != 0) {
+		MatrixKeypad_repeat(keypad, timed ? time : (uint16_t)millis());
+	}
+#endif
+#if MATRIXKEYPAD_ADAPTIVE
+	keypad->active = (any != 0);
+#endif
+	if(any == 0) {
+		keypad->lastKey = '\0';
+#if MATRIXKEYPAD_INTERRUPTS
+		if(keypad->idleMode) { /* all keys released, goes back to idle */
+			MatrixKeypad_arm(keypad);
+		}
+#endif
+	}
+}
+#else
+/* Saves the key detected by a complete scan of the keypad */
+static void MatrixKeypad_publish (MatrixKeypad_t *keypad, char key){
+	
+#if MATRIXKEYPAD_CALLBACKS && !MATRIXKEYPAD_DEFERRED_CALLBACKS
+	char released;
+#endif
+	
+	if(keypad->lastKey != key) {	/* saves the key in the buffer only if the last key was released */
+#if MATRIXKEYPAD_CALLBACKS && !MATRIXKEYPAD_DEFERRED_CALLBACKS
+		released = keypad->lastKey;
+#endif
+		keypad->lastKey = key;		/* because the buffer is flushed after a reading */
+		if(key != '\0') {			/* don't overwrite the buffer when the key is released. Important when the scan interval is higher than the time of the keypress */
+			MatrixKeypad_deliver(keypad, key);
+		}
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+		MATRIXKEYPAD_SCAN_LOCK();
+		if(key != '\0') {
+			keypad->pressLatch = key;
+		}
+		keypad->pending = 1;
+		MATRIXKEYPAD_SCAN_UNLOCK();
+#elif MATRIXKEYPAD_CALLBACKS
+		if(released != '\0' && keypad->onRelease != NULL) {
+			keypad->onRelease(keypad, MATRIXKEYPAD_ITEM_KEY(keypad, released));
+		}
+		if(key != '\0' && keypad->onPress != NULL) {
+			keypad->onPress(keypad, MATRIXKEYPAD_ITEM_KEY(keypad, key));
+		}
+#endif
+	}
+	
+#if MATRIXKEYPAD_ADAPTIVE
+	keypad->active = (key != '\0');
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+	if(keypad->idleMode && key == '\0') { /* all keys released, goes back to idle */
+		MatrixKeypad_arm(keypad);
+	}
+#endif
+}
+#endif
+
+#if MATRIXKEYPAD_TRANSPORT
+/* Processes the frame scanned by the hardware of the transport. The rows aren't strobed, so the scan only compares the finished frame */
+static void MatrixKeypad_readFrame (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_MULTIKEY
+	keypad->transport->readFrame(keypad->transport->context, keypad->raw);
+	MatrixKeypad_processFrame(keypad);
+#else
+	MatrixKeypad_cols_t frame[MATRIXKEYPAD_MAX_ROWS], cols;
+	uint8_t row, col;
+	uint16_t index;
+	char key = '\0';
+	
+	keypad->transport->readFrame(keypad->transport->context, frame);
+	for(row = 0, index = 0; row < MATRIXKEYPAD_ROWN(keypad); row++, index += MATRIXKEYPAD_COLN(keypad)){
+		for(col = 0, cols = frame[row]; cols != 0; col++, cols >>= 1){
+			if(cols & 1) {
+				key = MATRIXKEYPAD_ITEM(keypad, index + col); /* the last key found, as the row by row scan */
+			}
+		}
+#if MATRIXKEYPAD_EARLY_EXIT
+		if(key != '\0') {
+			break;
+		}
+#endif
+	}
+	MatrixKeypad_publish(keypad, key);
+#endif
+}
+#endif
+
+/* Discards the frame in progress of MatrixKeypad_step, releasing its strobed row */
+static inline void MatrixKeypad_abortFrame (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_USE_STEP
+	if(keypad->scanRow != 0) {
+		MatrixKeypad_releaseRows(keypad, keypad->scanRow - 1);
+		keypad->scanRow = 0;
+	}
+#else
+	(void)keypad; /* no frame is scanned in parts */
+#endif
+}
+
+void MatrixKeypad_scan (MatrixKeypad_t *keypad){
+	
+	uint8_t row;
+#if !MATRIXKEYPAD_MULTIKEY
+	uint16_t index;
+	char key = '\0'; /* the "not detected" key */
+#endif
+#if MATRIXKEYPAD_STATS
+	uint32_t start;
+#endif
+	
+	if(keypad != NULL) {
+		
+#if MATRIXKEYPAD_TIMER
+		if(keypad->timed) { /* the timer interrupt scans the keypad */
+			return;
+		}
+#endif
+		MatrixKeypad_abortFrame(keypad); /* a frame of MatrixKeypad_step in progress is replaced by this one */
+		if(MatrixKeypad_skipIdle(keypad)) {
+			return;
+		}
+#if MATRIXKEYPAD_STATS
+		start = micros();
+		keypad->statsStart = start;
+		keypad->statsBusy = 0;
+#endif
+#if MATRIXKEYPAD_TRANSPORT
+		if(keypad->transport != NULL && keypad->transport->readFrame != NULL) { /* the hardware scanned the rows */
+			MatrixKeypad_readFrame(keypad);
+#if MATRIXKEYPAD_STATS
+			MatrixKeypad_statsFrame(keypad, start);
+#endif
+			return;
+		}
+#endif
+		
+		/* How the hardware works
+		 * 
+		 * The keypad is a matrix which each row and column is a wire. All wires are disconnected from each other.
+		 * When a button is pressed the corresponding row and column wires are shorted.
+		 * To detect that, the rows are set as outputs and held high and the columns are set as inputs with pullup resistors.
+		 * To scan a row, the row is set to low. If a key is pressed, the corresponding column will read as low. 
+		 * On the other side, if none key is pressed, the corresponding column will read as high.
+		 * 
+		 * To scan the keypad, each row is set to low and each column is read. If it reads a column as high, the corresponding key is pressed.
+		 */
+#if MATRIXKEYPAD_MULTIKEY
+#if MATRIXKEYPAD_USE_PROBE
+		if(!MatrixKeypad_probe(keypad)) { /* nothing pressed, the frame is empty */
+			for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+				keypad->raw[row] = 0;
+			}
+			MatrixKeypad_processFrame(keypad);
+#if MATRIXKEYPAD_STATS
+			MatrixKeypad_statsFrame(keypad, start);
+#endif
+			return;
+		}
+#endif
+		for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+			MatrixKeypad_selectRow(keypad, row);
+			MatrixKeypad_settle(keypad);
+			keypad->raw[row] = MatrixKeypad_readCols(keypad);
+		}
+		MatrixKeypad_releaseRows(keypad, MATRIXKEYPAD_ROWN(keypad) - 1);
+		
+		MatrixKeypad_processFrame(keypad);
+#if MATRIXKEYPAD_STATS
+		MatrixKeypad_statsFrame(keypad, start);
+#endif
+#else
+#if MATRIXKEYPAD_USE_PROBE
+		if(MatrixKeypad_probe(keypad)) {
+#endif
+			for(row = 0, index = 0; row < MATRIXKEYPAD_ROWN(keypad); row++, index += MATRIXKEYPAD_COLN(keypad)){
+				MatrixKeypad_selectRow(keypad, row);
+				MatrixKeypad_settle(keypad);
+				key = MatrixKeypad_readRowKey(keypad, index, key);
+#if MATRIXKEYPAD_EARLY_EXIT
+				if(key != '\0') { /* only one key is detected, the rows below aren't scanned */
+					break;
+				}
+#endif
+			}
+			MatrixKeypad_releaseRows(keypad, row < MATRIXKEYPAD_ROWN(keypad) ? row : MATRIXKEYPAD_ROWN(keypad) - 1);
+#if MATRIXKEYPAD_USE_PROBE
+		}
+#endif
+		
+		MatrixKeypad_publish(keypad, key);
+#if MATRIXKEYPAD_STATS
+		MatrixKeypad_statsFrame(keypad, start);
+#endif
+#endif
+	}
+
+}
+
+#if MATRIXKEYPAD_USE_STEP
+/* Scans the row "scanRow" and completes the frame after the last one. Returns 1 if the frame was completed */
+static uint8_t MatrixKeypad_stepRow (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_USE_PROBE && MATRIXKEYPAD_MULTIKEY
+	uint8_t row;
+#endif
+#if MATRIXKEYPAD_STATS
+	uint32_t start = micros();
+#endif
+	
+	if(keypad->scanRow == 0) {
+		if(MatrixKeypad_skipIdle(keypad)) {
+			return 0;
+		}
+#if MATRIXKEYPAD_STATS
+		keypad->statsStart = start;
+		keypad->statsBusy = 0;
+#endif
+		keypad->frameKey = '\0';
+		keypad->scanIndex = 0;
+#if MATRIXKEYPAD_TRANSPORT
+		if(keypad->transport != NULL && keypad->transport->readFrame != NULL) { /* the whole frame is ready, completed in this call */
+			MatrixKeypad_readFrame(keypad);
+#if MATRIXKEYPAD_STATS
+			MatrixKeypad_statsFrame(keypad, start);
+#endif
+			return 1;
+		}
+#endif
+#if MATRIXKEYPAD_USE_PROBE
+		if(!MatrixKeypad_probe(keypad)) { /* nothing pressed, the empty frame is completed in this call */
+#if MATRIXKEYPAD_MULTIKEY
+			for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+				keypad->raw[row] = 0;
+			}
+			MatrixKeypad_processFrame(keypad);
+#else
+			MatrixKeypad_publish(keypad, '\0');
+#endif
+#if MATRIXKEYPAD_STATS
+			MatrixKeypad_statsFrame(keypad, start);
+#endif
+			return 1;
+		}
+#endif
+	}
+	
+	/* the row stays strobed until the next call, so the previous row is released in the next select */
+	MatrixKeypad_selectRow(keypad, keypad->scanRow);
+	MatrixKeypad_settle(keypad);
+#if MATRIXKEYPAD_MULTIKEY
+	keypad->raw[keypad->scanRow] = MatrixKeypad_readCols(keypad);
+#else
+	keypad->frameKey = MatrixKeypad_readRowKey(keypad, keypad->scanIndex, keypad->frameKey);
+	keypad->scanIndex += MATRIXKEYPAD_COLN(keypad);
+#endif
+	keypad->scanRow++;
+	
+#if MATRIXKEYPAD_EARLY_EXIT && !MATRIXKEYPAD_MULTIKEY
+	if(keypad->scanRow == MATRIXKEYPAD_ROWN(keypad) || keypad->frameKey != '\0') { /* only one key is detected, the rows below aren't scanned */
+#else
+	if(keypad->scanRow == MATRIXKEYPAD_ROWN(keypad)) {
+#endif
+		MatrixKeypad_releaseRows(keypad, keypad->scanRow - 1);
+		keypad->scanRow = 0;
+#if MATRIXKEYPAD_MULTIKEY
+		MatrixKeypad_processFrame(keypad);
+#else
+		MatrixKeypad_publish(keypad, keypad->frameKey);
+#endif
+#if MATRIXKEYPAD_STATS
+		MatrixKeypad_statsFrame(keypad, start);
+#endif
+		return 1;
+	}
+	
+#if MATRIXKEYPAD_STATS
+	keypad->statsBusy += micros() - start;
+#endif
+	return 0;
+}
+
+#endif
+
+#if MATRIXKEYPAD_USE_STEP
+uint8_t MatrixKeypad_step (MatrixKeypad_t *keypad){
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+#if MATRIXKEYPAD_TIMER
+	if(keypad->timed) { /* the timer interrupt scans the keypad */
+		return 0;
+	}
+#endif
+	
+	return MatrixKeypad_stepRow(keypad);
+}
+#endif
+
+#if MATRIXKEYPAD_USE_SHARED
+/* Returns the keypad "i" of a list of keypad pointers or, if "list" is NULL, of a contiguous array of keypads */
+static inline MatrixKeypad_t *MatrixKeypad_member (MatrixKeypad_t **list, MatrixKeypad_t *array, uint8_t i){
+	
+	return list != NULL ? list[i] : &array[i];
+}
+
+/* Scans "keypadn" keypads that share the row pins. Each row is strobed once, through the first keypad, and the columns of all keypads are read */
+static void MatrixKeypad_scanShared (MatrixKeypad_t **list, MatrixKeypad_t *array, uint8_t keypadn){
+	
+	MatrixKeypad_t *rows, *keypad;
+	uint8_t row, i;
+#if MATRIXKEYPAD_EARLY_EXIT
+	uint8_t any;
+#endif
+#if MATRIXKEYPAD_EARLY_EXIT && !MATRIXKEYPAD_MULTIKEY
+	uint8_t found = 0;
+#endif
+#if MATRIXKEYPAD_STATS
+	uint32_t start;
+#endif
+	
+	rows = MatrixKeypad_member(list, array, 0); /* drives the shared rows */
+#if MATRIXKEYPAD_STATS
+	start = micros();
+#endif
+	for(i = 0; i < keypadn; i++){
+		keypad = MatrixKeypad_member(list, array, i);
+		MatrixKeypad_abortFrame(keypad); /* a frame of MatrixKeypad_step in progress is replaced by this one */
+#if !MATRIXKEYPAD_MULTIKEY
+		keypad->frameKey = '\0';
+		keypad->scanIndex = 0;
+#endif
+#if MATRIXKEYPAD_STATS
+		keypad->statsStart = start;
+		keypad->statsBusy = 0;
+#endif
+	}
+	
+#if MATRIXKEYPAD_EARLY_EXIT
+	MatrixKeypad_writeRows(rows, LOW); /* the probe of MatrixKeypad_scan, with the columns of all keypads */
+	MatrixKeypad_settle(rows);
+	for(i = 0, any = 0; i < keypadn && !any; i++){
+		any = MatrixKeypad_anyColLow(MatrixKeypad_member(list, array, i));
+	}
+	MatrixKeypad_writeRows(rows, HIGH);
+	
+	if(any) {
+#endif
+		for(row = 0; row < MATRIXKEYPAD_ROWN(rows); row++){
+			MatrixKeypad_selectRow(rows, row);
+			MatrixKeypad_settle(rows);
+			for(i = 0; i < keypadn; i++){ /* one strobe for all keypads */
+				keypad = MatrixKeypad_member(list, array, i);
+#if MATRIXKEYPAD_MULTIKEY
+				keypad->raw[row] = MatrixKeypad_readCols(keypad);
+#else
+#if MATRIXKEYPAD_EARLY_EXIT
+				if(keypad->frameKey != '\0') { /* only one key is detected, the rows below aren't read */
+					continue;
+				}
+#endif
+				keypad->frameKey = MatrixKeypad_readRowKey(keypad, keypad->scanIndex, keypad->frameKey);
+				keypad->scanIndex += MATRIXKEYPAD_COLN(keypad);
+#if MATRIXKEYPAD_EARLY_EXIT
+				found += keypad->frameKey != '\0';
+#endif
+#endif
+			}
+#if MATRIXKEYPAD_EARLY_EXIT && !MATRIXKEYPAD_MULTIKEY
+			if(found == keypadn) { /* all keypads have a key, the rows below aren't scanned */
+				break;
+			}
+#endif
+		}
+		MatrixKeypad_releaseRows(rows, row < MATRIXKEYPAD_ROWN(rows) ? row : MATRIXKEYPAD_ROWN(rows) - 1);
+#if MATRIXKEYPAD_EARLY_EXIT
+	}
+#if MATRIXKEYPAD_MULTIKEY
+	else {
+		for(i = 0; i < keypadn; i++){ /* nothing pressed, the frames are empty */
+			keypad = MatrixKeypad_member(list, array, i);
+			for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+				keypad->raw[row] = 0;
+			}
+		}
+	}
+#endif
+#endif
+	
+	for(i = 0; i < keypadn; i++){
+		keypad = MatrixKeypad_member(list, array, i);
+#if MATRIXKEYPAD_MULTIKEY
+		MatrixKeypad_processFrame(keypad);
+#else
+		MatrixKeypad_publish(keypad, keypad->frameKey);
+#endif
+#if MATRIXKEYPAD_STATS
+		MatrixKeypad_statsFrame(keypad, start); /* each keypad counts the whole frame it shares */
+#endif
+	}
+}
+#endif
+
+#if MATRIXKEYPAD_USE_SHARED
+/* Returns 1 if the keypad can be strobed by a neighbour of its array, 0 if it needs its own MatrixKeypad_scan */
+static inline uint8_t MatrixKeypad_canShare (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_TRANSPORT
+	if(keypad->transport != NULL) { /* the rows are behind the transport */
+		return 0;
+	}
+#endif
+#if MATRIXKEYPAD_TIMER
+	if(keypad->timed) { /* the timer interrupt scans the keypad */
+		return 0;
+	}
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+	if(keypad->idleMode) { /* the rows are held LOW by the idle mode */
+		return 0;
+	}
+#endif
+	(void)keypad;
+	return 1;
+}
+
+/* Returns 1 if the two keypads have the same rows, so one strobe serves both */
+static inline uint8_t MatrixKeypad_sharesRows (MatrixKeypad_t *a, MatrixKeypad_t *b){
+	
+#if MATRIXKEYPAD_SETTLE
+	if(a->settleTime != b->settleTime) { /* the shared strobe waits the settle time of the first keypad */
+		return 0;
+	}
+#endif
+#if MATRIXKEYPAD_COMPACT
+	if(a->layout == b->layout) { /* the same layout, its pins aren't read */
+		return 1;
+	}
+#endif
+	return MATRIXKEYPAD_ROWPINS(a) == MATRIXKEYPAD_ROWPINS(b) && MATRIXKEYPAD_ROWN(a) == MATRIXKEYPAD_ROWN(b);
+}
+#endif
+
+void MatrixKeypad_scanArray (MatrixKeypad_t *keypads, uint8_t keypadn){
+	
+	uint8_t first, n;
+	
+	if(keypads == NULL) {
+		return;
+	}
+	
+	for(first = 0; first < keypadn; first += n){
+		n = 1;
+#if MATRIXKEYPAD_USE_SHARED
+		if(MatrixKeypad_canShare(&keypads[first])) { /* the neighbours with the same rows are scanned together */
+			while(first + n < keypadn && MatrixKeypad_canShare(&keypads[first + n]) && MatrixKeypad_sharesRows(&keypads[first], &keypads[first + n])) {
+				n++;
+			}
+		}
+		if(n > 1) {
+			MatrixKeypad_scanShared(NULL, &keypads[first], n);
+			continue;
+		}
+#endif
+		MatrixKeypad_scan(&keypads[first]);
+	}
+}
+
+#if MATRIXKEYPAD_GROUP
+uint8_t MatrixKeypad_initGroup (MatrixKeypad_group_t *group, MatrixKeypad_t **keypads, uint8_t keypadn){
+	
+	uint8_t i, row;
+	
+	if(group == NULL || keypads == NULL || keypadn == 0 || keypads[0] == NULL) {
+		return 0;
+	}
+	
+	for(i = 0; i < keypadn; i++){
+		if(keypads[i] == NULL) {
+			continue;
+		}
+#if MATRIXKEYPAD_TRANSPORT
+		if(keypads[i]->transport != NULL) { /* the shared rows are compared by pin */
+			return 0;
+		}
+#endif
+#if MATRIXKEYPAD_TIMER
+		if(keypads[i]->timed) { /* the timer interrupt would strobe the shared rows in the middle of the group scan */
+			return 0;
+		}
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+		if(keypads[i]->idleMode) { /* the idle mode holds the shared rows LOW */
+			return 0;
+		}
+#endif
+	}
+	
+	for(i = 1; i < keypadn; i++){
+		if(keypads[i] == NULL || MATRIXKEYPAD_ROWN(keypads[i]) != MATRIXKEYPAD_ROWN(keypads[0])) {
+			return 0;
+		}
+		for(row = 0; row < MATRIXKEYPAD_ROWN(keypads[0]); row++){
+			if(MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypads[i]), row) != MATRIXKEYPAD_PIN(MATRIXKEYPAD_ROWPINS(keypads[0]), row)) {
+				return 0;
+			}
+		}
+	}
+	
+	group->keypads = keypads;
+	group->keypadn = keypadn;
+	
+	return 1;
+}
+
+void MatrixKeypad_scanGroup (MatrixKeypad_group_t *group){
+	
+	uint8_t i;
+	
+	if(group == NULL) {
+		return;
+	}
+	
+	for(i = 0; i < group->keypadn; i++){
+#if MATRIXKEYPAD_TIMER
+		if(group->keypads[i]->timed) { /* the timer interrupt scans the keypad, like MatrixKeypad_scan */
+			return;
+		}
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+		if(group->keypads[i]->idleMode) { /* the rows are held LOW by the idle mode, they can't be strobed */
+			return;
+		}
+#endif
+	}
+	
+	MatrixKeypad_scanShared(group->keypads, NULL, group->keypadn);
+}
+#endif
+
+#if MATRIXKEYPAD_SETTLE
+void MatrixKeypad_setSettleTime (MatrixKeypad_t *keypad, uint8_t time){
+	
+	if(keypad != NULL) {
+		keypad->settleTime = time;
+	}
+}
+#endif
+
+#if MATRIXKEYPAD_ADAPTIVE
+void MatrixKeypad_setScanInterval (MatrixKeypad_t *keypad, uint16_t active, uint16_t idle){
+	
+	if(keypad != NULL) {
+		keypad->activeInterval = active;
+		keypad->idleInterval = idle;
+	}
+}
+
+uint8_t MatrixKeypad_poll (MatrixKeypad_t *keypad){
+	
+	uint32_t now;
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+	
+	now = millis();
+	if((uint32_t)(now - keypad->lastScan) < (keypad->active ? keypad->activeInterval : keypad->idleInterval)) {
+		return 0;
+	}
+	keypad->lastScan = now;
+	MatrixKeypad_scan(keypad);
+	
+	return 1;
+}
+#endif
+
+#if MATRIXKEYPAD_TIMER
+void MatrixKeypad_tick (MatrixKeypad_t *keypad){
+	
+	if(keypad != NULL) {
+		MatrixKeypad_stepRow(keypad);
+	}
+}
+
+#if MATRIXKEYPAD_USE_TIMER2
+static MatrixKeypad_t * volatile MatrixKeypad_timerKeypad = NULL; /* keypad scanned by the Timer2 interrupt */
+
+ISR(TIMER2_COMPA_vect) {
+	MatrixKeypad_tick(MatrixKeypad_timerKeypad);
+}
+#elif MATRIXKEYPAD_USE_ESP_TIMER
+static esp_timer_handle_t MatrixKeypad_timerHandle = NULL;
+static MatrixKeypad_t *MatrixKeypad_timerKeypad = NULL;
+
+static void MatrixKeypad_timerCallback (void *arg){
+	MatrixKeypad_tick((MatrixKeypad_t*)arg);
+}
+#endif
+
+uint8_t MatrixKeypad_startTimer (MatrixKeypad_t *keypad, uint32_t period){
+	
+#if MATRIXKEYPAD_USE_TIMER2
+	/* clock select bits of each Timer2 prescaler */
+	static const uint16_t prescalers[] = {1, 8, 32, 64, 128, 256, 1024};
+	uint32_t ticks = (F_CPU / 1000000UL) * period;
+	uint8_t cs;
+	
+	if(keypad == NULL || MatrixKeypad_timerKeypad != NULL || period == 0 || period > 65535UL) { /* also avoids the overflow of "ticks" */
+		return 0;
+	}
+	for(cs = 0; cs < 7 && (ticks / prescalers[cs]) > 256; cs++);
+	if(cs == 7) { /* the period is longer than the 8 bit timer can count */
+		return 0;
+	}
+	
+	MatrixKeypad_abortFrame(keypad);
+	keypad->timed = 1;
+	MatrixKeypad_timerKeypad = keypad;
+	
+	noInterrupts();
+	TCCR2A = (1 << WGM21); /* CTC mode, counts up to OCR2A */
+	TCCR2B = cs + 1;
+	OCR2A = (ticks / prescalers[cs]) - 1;
+	TCNT2 = 0;
+	TIFR2 = (1 << OCF2A);
+	TIMSK2 = (1 << OCIE2A);
+	interrupts();
+	
+	return 1;
+#elif MATRIXKEYPAD_USE_ESP_TIMER
+	esp_timer_create_args_t args = {
+		.callback = MatrixKeypad_timerCallback,
+		.arg = keypad,
+		.name = "MatrixKeypad"
+	};
+	
+	if(keypad == NULL || MatrixKeypad_timerKeypad != NULL || period == 0) {
+		return 0;
+	}
+	
+	MatrixKeypad_abortFrame(keypad);
+	keypad->timed = 1;
+	if(esp_timer_create(&args, &MatrixKeypad_timerHandle) != ESP_OK) {
+		keypad->timed = 0;
+		return 0;
+	}
+	if(esp_timer_start_periodic(MatrixKeypad_timerHandle, period) != ESP_OK) {
+		esp_timer_delete(MatrixKeypad_timerHandle);
+		keypad->timed = 0;
+		return 0;
+	}
+	MatrixKeypad_timerKeypad = keypad;
+	
+	return 1;
+#else
+	(void)keypad; /* no timer is supported on this core. Call MatrixKeypad_tick from your own timer interrupt */
+	(void)period;
+	return 0;
+#endif
+}
+
+void MatrixKeypad_stopTimer (MatrixKeypad_t *keypad){
+	
+	if(keypad == NULL || !keypad->timed) {
+		return;
+	}
+	
+#if MATRIXKEYPAD_USE_TIMER2
+	TIMSK2 = 0;
+	TCCR2B = 0;
+	MatrixKeypad_timerKeypad = NULL;
+#elif MATRIXKEYPAD_USE_ESP_TIMER
+	esp_timer_stop(MatrixKeypad_timerHandle);
+	esp_timer_delete(MatrixKeypad_timerHandle);
+	MatrixKeypad_timerHandle = NULL;
+	MatrixKeypad_timerKeypad = NULL;
+#endif
+	
+	MatrixKeypad_abortFrame(keypad); /* a frame was interrupted in the middle */
+	keypad->timed = 0;
+}
+#endif
+
+uint8_t MatrixKeypad_hasKey (MatrixKeypad_t *keypad){
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+	
+#if MATRIXKEYPAD_USE_QUEUE
+#if MATRIXKEYPAD_EVENTS
+	MatrixKeypad_skipToPress(keypad);
+#endif
+	if(keypad->queueHead != keypad->queueTail){
+		return 1;
+	}
+#elif MATRIXKEYPAD_USE_SEQ
+	if(keypad->bufferSeq != keypad->bufferAck){ /* a key was published and not read yet */
+		return 1;
+	}
+#else
+	if(keypad->buffer != '\0'){
+		return 1;
+	}
+#endif
+	
+	return 0;
+}
+
+/* Removes the oldest unread key from the buffer or the queue and returns the value saved by the scan (MATRIXKEYPAD_ITEM) or '\0' */
+static char MatrixKeypad_take (MatrixKeypad_t *keypad){
+	
+	char key;
+#if MATRIXKEYPAD_USE_QUEUE
+	uint8_t tail;
+#elif MATRIXKEYPAD_USE_SEQ
+	uint8_t seq;
+#endif
+#if MATRIXKEYPAD_STATS
+	uint16_t time;
+#endif
+	
+#if MATRIXKEYPAD_USE_QUEUE
+#if MATRIXKEYPAD_EVENTS
+	MatrixKeypad_skipToPress(keypad);
+#endif
+	tail = keypad->queueTail;
+	if(tail == keypad->queueHead) {
+		return '\0';
+	}
+#if MATRIXKEYPAD_EVENTS
+	key = MATRIXKEYPAD_ITEM(keypad, keypad->queue[tail & (MATRIXKEYPAD_QUEUE_SIZE - 1)].key);
+#if MATRIXKEYPAD_STATS
+	time = keypad->queue[tail & (MATRIXKEYPAD_QUEUE_SIZE - 1)].time;
+#endif
+#else
+	key = keypad->queue[tail & (MATRIXKEYPAD_QUEUE_SIZE - 1)];
+#if MATRIXKEYPAD_STATS
+	time = keypad->queueTime[tail & (MATRIXKEYPAD_QUEUE_SIZE - 1)];
+#endif
+#endif
+	keypad->queueTail = tail + 1; /* frees the slot after reading it */
+#elif MATRIXKEYPAD_USE_SEQ
+	/* the timer interrupt can publish a key at any time. Instead of disabling the interrupts,
+	 * the read is repeated if a key was published while reading the buffer
+	 */
+	do {
+		seq = keypad->bufferSeq;
+		key = keypad->buffer;
+#if MATRIXKEYPAD_STATS
+		time = keypad->bufferTime;
+#endif
+	} while(seq != keypad->bufferSeq);
+	
+	if(seq == keypad->bufferAck) {
+		return '\0';
+	}
+	keypad->bufferAck = seq; /* a key press event can be read only one time */
+#else
+	key = keypad->buffer;
+	keypad->buffer = '\0'; /* a key press event can be read only one time.
+						    * the buffer is cleared after its read to avoid reading
+							* the same key press event many times
+							*/
+#if MATRIXKEYPAD_STATS
+	if(key == '\0') {
+		return '\0';
+	}
+	time = keypad->bufferTime;
+#endif
+#endif
+	
+#if MATRIXKEYPAD_STATS
+	MatrixKeypad_statsLatency(keypad, time);
+#endif
+	return key;
+}
+
+char MatrixKeypad_getKey (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_INDEX
+	uint8_t item;
+#endif
+	
+	if(keypad == NULL) {
+		return '\0';
+	}
+	
+#if MATRIXKEYPAD_INDEX
+	item = (uint8_t)MatrixKeypad_take(keypad);
+	return item != 0 ? MATRIXKEYPAD_KEY(MATRIXKEYPAD_KEYMAP(keypad), item - 1) : '\0'; /* the mapping is read only now */
+#else
+	return MatrixKeypad_take(keypad);
+#endif
+}
+
+#if MATRIXKEYPAD_INDEX
+uint8_t MatrixKeypad_getKeyIndex (MatrixKeypad_t *keypad){
+	
+	uint8_t item;
+	
+	if(keypad == NULL) {
+		return MATRIXKEYPAD_NO_KEY;
+	}
+	
+	item = (uint8_t)MatrixKeypad_take(keypad);
+	return item != 0 ? item - 1 : MATRIXKEYPAD_NO_KEY;
+}
+
+uint8_t MatrixKeypad_setLookup (MatrixKeypad_t *keypad, const void *table, uint8_t size){
+	
+	if(keypad == NULL || (size != 1 && size != 2 && size != 4)) {
+		return 0;
+	}
+	
+	keypad->lookup = table;
+	keypad->lookupSize = size;
+	
+	return 1;
+}
+
+uint32_t MatrixKeypad_lookup (MatrixKeypad_t *keypad, uint8_t index){
+	
+	if(keypad == NULL || keypad->lookup == NULL || index >= MATRIXKEYPAD_ROWN(keypad) * MATRIXKEYPAD_COLN(keypad)) {
+		return 0;
+	}
+	
+	switch(keypad->lookupSize) {
+#if MATRIXKEYPAD_USE_PGM
+		case 1: return pgm_read_byte(&((const uint8_t *)keypad->lookup)[index]);
+		case 2: return pgm_read_word(&((const uint16_t *)keypad->lookup)[index]);
+		default: return pgm_read_dword(&((const uint32_t *)keypad->lookup)[index]);
+#else
+		case 1: return ((const uint8_t *)keypad->lookup)[index];
+		case 2: return ((const uint16_t *)keypad->lookup)[index];
+		default: return ((const uint32_t *)keypad->lookup)[index];
+#endif
+	}
+}
+#endif
+
+#if MATRIXKEYPAD_DEEP_SLEEP
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+static uint8_t MatrixKeypad_eicStandby = 0; /* 1 after the EIC is moved to a clock that runs in standby */
+#endif
+
+/* Sleeps in the deepest mode that the column interrupts can wake, while the keypad is idle. Returns 0 if the keypad or the core can't sleep this way */
+static uint8_t MatrixKeypad_deepSleep (MatrixKeypad_t *keypad){
+	
+	uint8_t col, pin;
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+	int ext;
+#endif
+	
+	if(!keypad->armed) { /* a key is pressed or being scanned */
+		return 0;
+	}
+	
+#if defined(__AVR__) && MATRIXKEYPAD_USE_PCINT
+	/* The external interrupts only wake the power-down mode on a LOW level, so every column uses its pin change interrupt while sleeping */
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		if(digitalPinToPCICR(MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col)) == 0) {
+			return 0;
+		}
+	}
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		*digitalPinToPCMSK(pin) |= (1 << digitalPinToPCMSKbit(pin));
+		*digitalPinToPCICR(pin) |= (1 << digitalPinToPCICRbit(pin));
+	}
+	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+	noInterrupts();
+	if(!keypad->wake && !MatrixKeypad_hasKey(keypad)) {
+		sleep_enable();
+		interrupts(); /* the instruction after "sei" is always executed, so an interrupt can't be missed before the sleep */
+		sleep_cpu();
+		sleep_disable();
+	}
+	interrupts();
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		if(digitalPinToInterrupt(pin) != NOT_AN_INTERRUPT) { /* back to the external interrupt */
+			*digitalPinToPCMSK(pin) &= ~(1 << digitalPinToPCMSKbit(pin));
+		}
+	}
+	
+	return 1;
+#elif defined(ESP32)
+	/* The GPIO wakeup is level triggered and changes the interrupt type of the pins, so the edge interrupts are detached while sleeping */
+	MatrixKeypad_colInterrupts(keypad, 0);
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_LOW_LEVEL);
+	}
+	esp_sleep_enable_gpio_wakeup();
+	if(!keypad->wake) {
+		esp_light_sleep_start(); /* a key pressed before this call wakes the core at once */
+	}
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		gpio_wakeup_disable((gpio_num_t)pin);
+	}
+	MatrixKeypad_colInterrupts(keypad, 1);
+	keypad->wake = 1; /* the edge happened while the interrupts were detached. A spurious wake only costs one scan */
+	
+	return 1;
+#elif defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		ext = g_APinDescription[pin].ulExtInt;
+		if(ext == NOT_AN_INTERRUPT || ext > 15) { /* the NMI pin has no wakeup */
+			return 0;
+		}
+	}
+	if(!MatrixKeypad_eicStandby) { /* the EIC detects the edges in standby only if its clock keeps running. Uses the generic clock 6 on the OSCULP32K */
+		GCLK->GENCTRL.reg = GCLK_GENCTRL_GENEN | GCLK_GENCTRL_SRC_OSCULP32K | GCLK_GENCTRL_ID(6) | GCLK_GENCTRL_RUNSTDBY;
+		while(GCLK->STATUS.bit.SYNCBUSY);
+		GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK6 | GCLK_CLKCTRL_ID(GCM_EIC));
+		while(GCLK->STATUS.bit.SYNCBUSY);
+		MatrixKeypad_eicStandby = 1;
+	}
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		EIC->WAKEUP.reg |= (1UL << g_APinDescription[pin].ulExtInt);
+	}
+	noInterrupts();
+	if(!keypad->wake && !MatrixKeypad_hasKey(keypad)) {
+		SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk; /* a pending tick can hang the entry in standby */
+		SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+		__DSB();
+		__WFI(); /* wakes on a pending interrupt even if they are disabled, so an edge can't be missed before the sleep */
+		SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+		SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+	}
+	interrupts();
+	for(col = 0; col < MATRIXKEYPAD_COLN(keypad); col++){
+		pin = MATRIXKEYPAD_PIN(MATRIXKEYPAD_COLPINS(keypad), col);
+		EIC->WAKEUP.reg &= ~(1UL << g_APinDescription[pin].ulExtInt);
+	}
+	
+	return 1;
+#else
+	(void)col; /* no deep sleep on this core */
+	(void)pin;
+	return 0;
+#endif
+}
+#endif
+
+#if MATRIXKEYPAD_WAIT_SLEEP
+/* Waits between two scans of the wait functions instead of spinning. Returns early if a key may be available.
+ * With "deep" and MATRIXKEYPAD_DEEP_SLEEP, sleeps in the deepest mode while the keypad is idle
+ */
+static void MatrixKeypad_waitIdle (MatrixKeypad_t *keypad, uint8_t deep){
 	
-	MatrixKeypad_t *keypad;
-	uint8_t i;
+#if MATRIXKEYPAD_DEEP_SLEEP
+	if(deep && MatrixKeypad_deepSleep(keypad)) {
+		return;
+	}
+#else
+	(void)deep;
+#endif
+#if MATRIXKEYPAD_USE_RTOS_WAIT
+	TickType_t ticks = pdMS_TO_TICKS(MATRIXKEYPAD_WAIT_INTERVAL);
+	
+	if(ticks == 0) { /* the tick is longer than the interval */
+		ticks = 1;
+	}
+#if MATRIXKEYPAD_INTERRUPTS
+	if(keypad->armed) { /* blocks until the column interrupt or the interval */
+		keypad->waitTask = xTaskGetCurrentTaskHandle();
+		if(!keypad->wake) { /* checked after publishing the task, so an edge between them leaves a pending notification */
+			ulTaskNotifyTake(pdTRUE, ticks);
+		}
+		keypad->waitTask = NULL;
+		return;
+	}
+#endif
+	(void)keypad;
+	vTaskDelay(ticks);
+#elif defined(__AVR__)
+	set_sleep_mode(SLEEP_MODE_IDLE); /* the timers and the pin interrupts keep running */
+	noInterrupts();
+#if MATRIXKEYPAD_INTERRUPTS
+	if(!MatrixKeypad_hasKey(keypad) && !(keypad->armed && keypad->wake)) {
+#else
+	if(!MatrixKeypad_hasKey(keypad)) { /* with MATRIXKEYPAD_TIMER, a key may have been saved after the last check */
+#endif
+		sleep_enable();
+		interrupts(); /* the instruction after "sei" is always executed, so an interrupt can't be missed before the sleep */
+		sleep_cpu();
+		sleep_disable();
+	}
+	interrupts();
+#else
+	(void)keypad;
+	yield();
+#endif
+}
+#endif
 
-	keypad = malloc(sizeof(MatrixKeypad_t));
+char MatrixKeypad_waitForKey (MatrixKeypad_t *keypad){
+	
+	char key;
+#if MATRIXKEYPAD_DEEP_SLEEP
+	uint8_t idleMode;
+#endif
+	
 	if(keypad == NULL) {
-		return NULL;
+		return '\0';
 	}
 	
-	keypad->rown = rown;
-	keypad->coln = coln;
-	keypad->rowPins = rowPins;
-	keypad->colPins = colPins;
-	keypad->keyMap = keymap;
-	keypad->lastKey = '\0';
-	keypad->buffer = '\0';
+#if MATRIXKEYPAD_DEEP_SLEEP
+	idleMode = keypad->idleMode;
+	MatrixKeypad_setIdleMode(keypad, 1); /* the column interrupts wake the core */
+#endif
+	/* scans the keypad until a key is pressed */
+	while(!MatrixKeypad_hasKey(keypad)) {	
+		MatrixKeypad_scan(keypad);
+#if MATRIXKEYPAD_WAIT_SLEEP
+		MatrixKeypad_waitIdle(keypad, 1);
+#endif
+	}
+	key = MatrixKeypad_getKey(keypad);
+#if MATRIXKEYPAD_DEEP_SLEEP
+	MatrixKeypad_setIdleMode(keypad, idleMode);
+#endif
 	
-	/* How the hardware works
-	 * 
-	 * The keypad is a matrix which each row and column is a wire. All wires are disconnected from each other.
-	 * When a button is pressed the corresponding row and column wires are shorted.
-	 * To detect that, the rows are set as outputs and held high and the columns are set as inputs with pullup resistors.
-	 * To scan a row, the row is set to low. If a key is pressed, the corresponding column will read as low. 
-	 */
-	for(i = 0; i < keypad->rown; i++){
-		pinMode(keypad->rowPins[i], OUTPUT);
-		digitalWrite(keypad->rowPins[i], HIGH);
+	return key;
+}
+
+/* Waits until a key is pressed or "timeout" units of the clock (millis or micros) elapse */
+static char MatrixKeypad_waitTimeout (MatrixKeypad_t *keypad, uint32_t timeout, uint8_t useMicros){
+	
+	uint32_t startTime, now;
+	
+	if(keypad == NULL) {
+		return '\0';
 	}
-	for(i = 0; i < keypad->coln; i++){
-		pinMode(keypad->colPins[i], INPUT_PULLUP);
+	
+	startTime = useMicros ? micros() : millis();
+	
+	/* scans the keypad until a key is pressed or a timeout occurs. The clock is read once per scan */
+	while(!MatrixKeypad_hasKey(keypad)) {
+		now = useMicros ? micros() : millis();
+		if(MATRIXKEYPAD_TIMED_OUT(startTime, now, timeout)) {
+			break;
+		}
+		MatrixKeypad_scan(keypad);
+#if MATRIXKEYPAD_WAIT_SLEEP
+		MatrixKeypad_waitIdle(keypad, 0);
+#endif
 	}
-    
-	return keypad;
+	
+	return MatrixKeypad_getKey(keypad);
 }
 
-void MatrixKeypad_scan (MatrixKeypad_t *keypad){
+char MatrixKeypad_waitForKeyTimeout (MatrixKeypad_t *keypad, uint16_t timeout){
 	
-	uint8_t row, col;
-	char key = '\0'; /* the "not detected" key */
+	return MatrixKeypad_waitTimeout(keypad, timeout, 0);
+}
+
+char MatrixKeypad_waitForKeyTimeoutMillis (MatrixKeypad_t *keypad, uint32_t timeout){
+	
+	return MatrixKeypad_waitTimeout(keypad, timeout, 0);
+}
+
+char MatrixKeypad_waitForKeyTimeoutMicros (MatrixKeypad_t *keypad, uint32_t timeout){
 	
+	return MatrixKeypad_waitTimeout(keypad, timeout, 1);
+}
+
+void MatrixKeypad_flush (MatrixKeypad_t *keypad){
+ 
 	if(keypad != NULL) {
-		
-		/* How the hardware works
-		 * 
-		 * The keypad is a matrix which each row and column is a wire. All wires are disconnected from each other.
-		 * When a button is pressed the corresponding row and column wires are shorted.
-		 * To detect that, the rows are set as outputs and held high and the columns are set as inputs with pullup resistors.
-		 * To scan a row, the row is set to low. If a key is pressed, the corresponding column will read as low. 
-		 * On the other side, if none key is pressed, the corresponding column will read as high.
-		 * 
-		 * To scan the keypad, each row is set to low and each column is read. If it reads a column as high, the corresponding key is pressed.
-		 */
-		for(row = 0; row < keypad->rown; row++){
-			
-			digitalWrite(keypad->rowPins[row], LOW);
-			for(col = 0; col < keypad->coln; col++){
-				if(digitalRead(keypad->colPins[col]) == LOW) {
-					key = keypad->keyMap[row * keypad->coln + col]; /* imagine as keyMap[row][col] */
-				}
-			}			
-			digitalWrite(keypad->rowPins[row], HIGH);
+
+#if MATRIXKEYPAD_USE_QUEUE
+		keypad->queueTail = keypad->queueHead;
+#elif MATRIXKEYPAD_USE_SEQ
+		keypad->bufferAck = keypad->bufferSeq;
+#else
+		keypad->buffer = '\0';
+#endif
+	} 
+}
+
+#if MATRIXKEYPAD_CALLBACKS
+void MatrixKeypad_setCallbacks (MatrixKeypad_t *keypad, MatrixKeypad_callback_t onPress, MatrixKeypad_callback_t onRelease){
+	
+	if(keypad == NULL) {
+		return;
+	}
+	
+	MATRIXKEYPAD_ENTER_CRITICAL(); /* the timer ISR can be scanning */
+	keypad->onPress = onPress;
+	keypad->onRelease = onRelease;
+	MATRIXKEYPAD_EXIT_CRITICAL();
+}
+
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+uint8_t MatrixKeypad_dispatch (MatrixKeypad_t *keypad){
+	
+#if MATRIXKEYPAD_MULTIKEY
+	MatrixKeypad_cols_t pressed[MATRIXKEYPAD_MAX_ROWS], state[MATRIXKEYPAD_MAX_ROWS], reported, released;
+	uint8_t row;
+	uint16_t index;
+#else
+	char pressed, state, reported;
+#endif
+	
+	if(keypad == NULL || !keypad->pending) { /* nothing changed since the last call */
+		return 0;
+	}
+	
+	MATRIXKEYPAD_ENTER_CRITICAL(); /* takes the keys of the scan at once, it can run in the timer ISR */
+	keypad->pending = 0;
+#if MATRIXKEYPAD_MULTIKEY
+	for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+		pressed[row] = keypad->pressLatch[row];
+		keypad->pressLatch[row] = 0;
+		state[row] = keypad->state[row];
+	}
+#else
+	pressed = keypad->pressLatch;
+	keypad->pressLatch = '\0';
+	state = keypad->lastKey;
+#endif
+	MATRIXKEYPAD_EXIT_CRITICAL();
+	
+	/* A key reported as pressed is released before a new press of it, or if it isn't pressed now.
+	 * A key pressed since the last call gets its press and, if it isn't pressed now, its release, so a short tap isn't lost */
+#if MATRIXKEYPAD_MULTIKEY
+	for(row = 0, index = 0; row < MATRIXKEYPAD_ROWN(keypad); row++, index += MATRIXKEYPAD_COLN(keypad)){
+		reported = keypad->reported[row];
+		released = reported & (pressed[row] | ~state[row]);
+		MatrixKeypad_notify(keypad, index, released, 0);
+		MatrixKeypad_notify(keypad, index, pressed[row], pressed[row]);
+		reported = (reported & ~released) | pressed[row];
+		MatrixKeypad_notify(keypad, index, reported & ~state[row], 0);
+		keypad->reported[row] = reported & state[row];
+	}
+#else
+	reported = keypad->reported;
+	if(reported != '\0' && (pressed != '\0' || state != reported)) {
+		if(keypad->onRelease != NULL) {
+			keypad->onRelease(keypad, MATRIXKEYPAD_ITEM_KEY(keypad, reported));
 		}
-		
-		if(keypad->lastKey != key) {	/* saves the key in the buffer only if the last key was released */
-			keypad->lastKey = key;		/* because the buffer is flushed after a reading */
-			if(key != '\0') {			/* don't overwrite the buffer when the key is released. Important when the scan interval is higher than the time of the keypress */
-				keypad->buffer = key;
-			}
+		reported = '\0';
+	}
+	if(pressed != '\0') {
+		if(keypad->onPress != NULL) {
+			keypad->onPress(keypad, MATRIXKEYPAD_ITEM_KEY(keypad, pressed));
+		}
+		reported = pressed;
+	}
+	if(reported != '\0' && state != reported) {
+		if(keypad->onRelease != NULL) {
+			keypad->onRelease(keypad, MATRIXKEYPAD_ITEM_KEY(keypad, reported));
 		}
+		reported = '\0';
 	}
+	keypad->reported = reported;
+#endif
+	
+	return 1;
+}
+#endif
+#endif
 
+#if MATRIXKEYPAD_USE_QUEUE
+uint8_t MatrixKeypad_getQueueDepth (MatrixKeypad_t *keypad){
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+	
+	return (uint8_t)(keypad->queueHead - keypad->queueTail);
 }
 
-uint8_t MatrixKeypad_hasKey (MatrixKeypad_t *keypad){
+uint16_t MatrixKeypad_getOverflowCount (MatrixKeypad_t *keypad){
+	
+	uint16_t count;
 	
 	if(keypad == NULL) {
 		return 0;
 	}
 	
-	if(keypad->buffer != '\0'){
-		return 1;
+	do { /* a 16 bit read isn't atomic on 8 bit cores. Reads again if the scan changed it in the middle */
+		count = keypad->overflows;
+	} while(count != keypad->overflows);
+	
+	return count;
+}
+#endif
+
+#if MATRIXKEYPAD_EVENTS
+uint8_t MatrixKeypad_getEvent (MatrixKeypad_t *keypad, MatrixKeypad_event_t *event){
+	
+	uint8_t tail;
+	
+	if(keypad == NULL || event == NULL) {
+		return 0;
+	}
+	
+	tail = keypad->queueTail;
+	if(tail == keypad->queueHead) {
+		return 0;
+	}
+	*event = keypad->queue[tail & (MATRIXKEYPAD_QUEUE_SIZE - 1)];
+	keypad->queueTail = tail + 1; /* frees the slot after reading it */
+#if MATRIXKEYPAD_STATS
+	if(event->type == MATRIXKEYPAD_EVENT_PRESS) {
+		MatrixKeypad_statsLatency(keypad, event->time);
+	}
+#endif
+	
+	return 1;
+}
+
+uint8_t MatrixKeypad_readEvents (MatrixKeypad_t *keypad, MatrixKeypad_event_t *events, uint8_t max){
+	
+	uint8_t tail, count, i;
+	
+	if(keypad == NULL || events == NULL) {
+		return 0;
+	}
+	
+	tail = keypad->queueTail;
+	count = (uint8_t)(keypad->queueHead - tail); /* the events added after this read are left for the next call */
+	if(count > max) {
+		count = max;
+	}
+	for(i = 0; i < count; i++){
+		events[i] = keypad->queue[(uint8_t)(tail + i) & (MATRIXKEYPAD_QUEUE_SIZE - 1)];
+#if MATRIXKEYPAD_STATS
+		if(events[i].type == MATRIXKEYPAD_EVENT_PRESS) {
+			MatrixKeypad_statsLatency(keypad, events[i].time);
+		}
+#endif
+	}
+	keypad->queueTail = tail + count; /* frees all slots at once after reading them */
+	
+	return count;
+}
+#endif
+
+#if MATRIXKEYPAD_REPEAT
+void MatrixKeypad_setRepeat (MatrixKeypad_t *keypad, uint16_t delay, uint16_t interval, uint16_t hold){
+	
+	if(keypad != NULL) {
+		keypad->repeatDelay = delay > 32767 ? 32767 : delay; /* the timer compares the times as signed 16 bit differences */
+		keypad->repeatInterval = interval > 32767 ? 32767 : interval;
+		keypad->holdTime = hold > 32767 ? 32767 : hold;
+	}
+}
+#endif
+
+#if MATRIXKEYPAD_MULTIKEY
+uint8_t MatrixKeypad_isPressed (MatrixKeypad_t *keypad, uint8_t row, uint8_t col){
+	
+	if(keypad == NULL || row >= MATRIXKEYPAD_ROWN(keypad) || col >= MATRIXKEYPAD_COLN(keypad)) {
+		return 0;
+	}
+	
+	return (keypad->state[row] >> col) & 1;
+}
+
+uint8_t MatrixKeypad_isKeyPressed (MatrixKeypad_t *keypad, char key){
+	
+	uint8_t row, col;
+	uint16_t index;
+	MatrixKeypad_cols_t cols;
+	
+	if(keypad == NULL) {
+		return 0;
+	}
+	
+	for(row = 0, index = 0; row < MATRIXKEYPAD_ROWN(keypad); row++, index += MATRIXKEYPAD_COLN(keypad)){
+		for(col = 0, cols = keypad->state[row]; cols != 0; col++, cols >>= 1){
+			if((cols & 1) && MATRIXKEYPAD_KEY(MATRIXKEYPAD_KEYMAP(keypad), index + col) == key) {
+				return 1;
+			}
+		}
 	}
 	
 	return 0;
 }
 
-char MatrixKeypad_getKey (MatrixKeypad_t *keypad){
+uint8_t MatrixKeypad_getPressedCount (MatrixKeypad_t *keypad){
 	
-	char key;
+	uint8_t row, count = 0;
+	MatrixKeypad_cols_t cols;
 	
 	if(keypad == NULL) {
-		return '\0';
+		return 0;
 	}
 	
-	key = keypad->buffer;
-	keypad->buffer = '\0'; /* a key press event can be read only one time.
-						    * the buffer is cleared after its read to avoid reading
-							* the same key press event many times
-							*/
+	for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){
+		for(cols = keypad->state[row]; cols != 0; cols &= cols - 1){ /* clears the lowest bit set */
+			count++;
+		}
+	}
 	
-	return key;
+	return count;
 }
 
-char MatrixKeypad_waitForKey (MatrixKeypad_t *keypad){
+MatrixKeypad_cols_t MatrixKeypad_getRowState (MatrixKeypad_t *keypad, uint8_t row){
 	
-	char key;
+	if(keypad == NULL || row >= MATRIXKEYPAD_ROWN(keypad)) {
+		return 0;
+	}
+	
+	return keypad->state[row];
+}
+
+MatrixKeypad_cols_t MatrixKeypad_getRowChanges (MatrixKeypad_t *keypad, uint8_t row){
+	
+	if(keypad == NULL || row >= MATRIXKEYPAD_ROWN(keypad)) {
+		return 0;
+	}
+	
+	return keypad->changes[row];
+}
+#endif
+
+#if MATRIXKEYPAD_GHOST
+uint8_t MatrixKeypad_isGhosted (MatrixKeypad_t *keypad){
 	
 	if(keypad == NULL) {
-		return '\0';
+		return 0;
 	}
 	
-	/* scans the keypad until a key is pressed */
-	while(!MatrixKeypad_hasKey(keypad)) {	
-		MatrixKeypad_scan(keypad);
+	return keypad->ghosted;
+}
+#endif
+
+#if MATRIXKEYPAD_DEBOUNCE
+uint8_t MatrixKeypad_setDebounce (MatrixKeypad_t *keypad, uint8_t count){
+	
+	uint8_t row, bit;
+	
+	if(keypad == NULL || count == 0 || count >= (1 << MATRIXKEYPAD_DEBOUNCE_BITS)) {
+		return 0;
 	}
-	key = MatrixKeypad_getKey(keypad);
 	
-	return key;
+	keypad->debounceCount = count;
+	for(row = 0; row < MATRIXKEYPAD_ROWN(keypad); row++){ /* a counter above the new count would never match it */
+		for(bit = 0; bit < MATRIXKEYPAD_DEBOUNCE_BITS; bit++){
+			keypad->counters[bit][row] = 0;
+		}
+	}
+	
+	return 1;
 }
+#endif
 
-char MatrixKeypad_waitForKeyTimeout (MatrixKeypad_t *keypad, uint16_t timeout){
+#if MATRIXKEYPAD_USE_RTOS
+/* Sends an item to all the subscriber queues without blocking. A full queue drops the item */
+static void MatrixKeypad_broadcast (MatrixKeypad_t *keypad, const void *item){
+	
+	uint8_t i, n = keypad->subscribern;
+	
+	for(i = 0; i < n; i++){
+		xQueueSend(keypad->subscribers[i], item, 0);
+	}
+}
+
+/* Body of the scan task. Scans the keypad and moves the keys from the keypad to the subscriber queues */
+static void MatrixKeypad_task (void *arg){
 	
+	MatrixKeypad_t *keypad = (MatrixKeypad_t*)arg;
+#if MATRIXKEYPAD_EVENTS
+	MatrixKeypad_event_t event;
+#else
 	char key;
-	uint16_t startTime = millis();
+#endif
 	
-	if(keypad == NULL) {
-		return '\0';
+	while(keypad->taskRun) {
+		MatrixKeypad_scan(keypad); /* doesn't scan while MATRIXKEYPAD_TIMER does, then only the keys are moved */
+#if MATRIXKEYPAD_EVENTS
+		while(MatrixKeypad_getEvent(keypad, &event)) {
+			MatrixKeypad_broadcast(keypad, &event);
+		}
+#else
+		while((key = MatrixKeypad_getKey(keypad)) != '\0') {
+			MatrixKeypad_broadcast(keypad, &key);
+		}
+#endif
+		
+#if MATRIXKEYPAD_INTERRUPTS
+		if(keypad->armed) { /* idle, nothing to scan until the column interrupt */
+			keypad->waitTask = xTaskGetCurrentTaskHandle();
+			if(!keypad->wake && keypad->taskRun) { /* checked after publishing the task, so an edge between them leaves a pending notification */
+				ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			}
+			keypad->waitTask = NULL;
+			continue;
+		}
+#endif
+		vTaskDelay(keypad->taskInterval);
 	}
 	
-	/* scans the keypad until a key is pressed or a timeout occurs */
-	while(!MatrixKeypad_hasKey(keypad) && ((millis() - startTime) <= timeout)) {	
-		MatrixKeypad_scan(keypad);
+	keypad->taskDone = 1; /* tells MatrixKeypad_stopTask that the task left the loop. The task is deleted by MatrixKeypad_stopTask, so it can still be notified */
+	for(;;) {
+		vTaskSuspend(NULL);
 	}
-	key = MatrixKeypad_getKey(keypad);
+}
+
+uint8_t MatrixKeypad_startTask (MatrixKeypad_t *keypad, uint16_t interval, uint8_t priority, uint8_t core){
 	
-	return key;
+	TaskHandle_t task;
+	
+	if(keypad == NULL || keypad->task != NULL) {
+		return 0;
+	}
+	
+	keypad->taskInterval = pdMS_TO_TICKS(interval);
+	if(keypad->taskInterval == 0) { /* the tick is longer than the interval */
+		keypad->taskInterval = 1;
+	}
+	keypad->taskRun = 1;
+	keypad->taskDone = 0;
+	if(xTaskCreatePinnedToCore(MatrixKeypad_task, "MatrixKeypad", MATRIXKEYPAD_RTOS_STACK, keypad, priority, &task, core) != pdPASS) {
+		keypad->taskRun = 0;
+		return 0;
+	}
+	keypad->task = task;
+	
+	return 1;
 }
 
-void MatrixKeypad_flush (MatrixKeypad_t *keypad){
- 
-	if(keypad != NULL) {
+void MatrixKeypad_stopTask (MatrixKeypad_t *keypad){
+	
+	TaskHandle_t task;
+	
+	if(keypad == NULL || keypad->task == NULL) {
+		return;
+	}
+	
+	task = keypad->task;
+	keypad->taskRun = 0;
+	xTaskNotifyGive(task); /* unblocks the task if it is waiting for the column interrupt. The task only ends when deleted below, so the handle is valid */
+	while(!keypad->taskDone) {
+		vTaskDelay(1);
+	}
+	vTaskDelete(task);
+	keypad->task = NULL;
+}
 
-		keypad->buffer = '\0';
-	} 
+uint8_t MatrixKeypad_subscribe (MatrixKeypad_t *keypad, QueueHandle_t queue){
+	
+	uint8_t n;
+	
+	if(keypad == NULL || queue == NULL) {
+		return 0;
+	}
+	
+	n = keypad->subscribern;
+	if(n == MATRIXKEYPAD_RTOS_SUBSCRIBERS) {
+		return 0;
+	}
+	keypad->subscribers[n] = queue;
+	keypad->subscribern = n + 1; /* publishes the queue to the task after writing it */
+	
+	return 1;
+}
+#endif
+
+#if MATRIXKEYPAD_STATS
+void MatrixKeypad_getStats (MatrixKeypad_t *keypad, MatrixKeypad_stats_t *stats){
+	
+	if(keypad == NULL || stats == NULL) {
+		return;
+	}
+	
+	MATRIXKEYPAD_ENTER_CRITICAL(); /* the timer interrupt can complete a frame in the middle of the copy */
+	*stats = keypad->stats;
+	MATRIXKEYPAD_EXIT_CRITICAL();
+	stats->averageTime = stats->scans != 0 ? stats->totalTime / stats->scans : 0;
+}
+
+void MatrixKeypad_resetStats (MatrixKeypad_t *keypad){
+	
+	uint8_t i;
+	
+	if(keypad == NULL) {
+		return;
+	}
+	
+	MATRIXKEYPAD_ENTER_CRITICAL();
+	keypad->stats.scans = 0;
+	keypad->stats.totalTime = 0;
+	keypad->stats.averageTime = 0;
+	keypad->stats.worstTime = 0;
+	keypad->stats.maxGap = 0;
+	keypad->stats.overwrites = 0;
+	keypad->stats.drops = 0;
+	for(i = 0; i < MATRIXKEYPAD_STATS_BUCKETS; i++){
+		keypad->stats.latency[i] = 0;
+	}
+	MATRIXKEYPAD_EXIT_CRITICAL();
 }
+#endif
@@ -19,7 +19,7 @@
 */
 /** 
  * @file MatrixKeypad.h
- * @version 1.1.0
+ * @version 1.2.0
  * @author Victor Henrique Salvi
  * 
  * Simple to use c-like Arduino library to interface matrix keypads.
@@ -28,15 +28,17 @@
  *  - blocking or non-blocking read; 
  *  - supports any number of rows and columns; 
  *  - user defined key mapping; 
- *  - prevents reading the same event twice.
+ *  - prevents reading the same event twice;
+ *  - optional direct port register backend (see MatrixKeypad_config.h).
  * 
  * Limitations 
- *  - don't handle multiples keypress simultaneously; 
- *  - saves only the last key pressed.
+ *  - don't handle multiples keypress simultaneously, unless MATRIXKEYPAD_MULTIKEY is enabled; 
+ *  - saves only the last key pressed, unless MATRIXKEYPAD_QUEUE_SIZE is greater than zero.
  *  
  * Changelog
  * |Version|Date|Contributor|Description|
  * |---|---|---|---|
+ * |1.2.0|2026/10/14|Victor Salvi|Added the static allocation, the compact keypads with shared layouts, the C++ template, the direct port register backend, the multiple keys scan with debouncing and ghost detection, the key queue, events, repeat and callbacks, the idle mode and the low power waits, the timer and FreeRTOS background scans, the incremental, group and array scans, the transport backends and the host simulation (see MatrixKeypad_config.h). Fixed the timeout after 65 seconds of uptime|
  * |1.1.0|2021/05/05|Victor Salvi|Added the MatrixKeypad_waitForKeyTimeout function|
  * |1.0.0|2021/05/05|Victor Salvi|Added the files to be compatible to the Arduino Library Manager (examples, properties file, keywords)|
  * |1.0.0|2021/05/05|Victor Salvi|Source code and usage documentation|
@@ -51,20 +53,319 @@
 #endif
 
 #include <stdint.h>
+#include "MatrixKeypad_config.h"
+
+#if MATRIXKEYPAD_USE_RTOS
+	#include "freertos/FreeRTOS.h"
+	#include "freertos/task.h"
+	#include "freertos/queue.h"
+#endif
 
 /** 
- * structure that holds the physical parameters of the keypad, the pin mapping, the key mapping and the state variables
+ * word that holds one bit for each column. The bit "C" represents the column "C"
+ */
+#if MATRIXKEYPAD_MAX_COLS <= 8
+	typedef uint8_t MatrixKeypad_cols_t;
+#elif MATRIXKEYPAD_MAX_COLS <= 16
+	typedef uint16_t MatrixKeypad_cols_t;
+#else
+	typedef uint32_t MatrixKeypad_cols_t;
+#endif
+
+#if MATRIXKEYPAD_INDEX
+#define MATRIXKEYPAD_NO_KEY 0xFF /**< Key index returned when no key was pressed */
+#endif
+
+#if MATRIXKEYPAD_EVENTS
+#define MATRIXKEYPAD_EVENT_PRESS 1 /**< The key was pressed */
+#define MATRIXKEYPAD_EVENT_RELEASE 2 /**< The key was released */
+#define MATRIXKEYPAD_EVENT_HOLD 3 /**< The key was held longer than the long press time */
+#define MATRIXKEYPAD_EVENT_REPEAT 4 /**< The key is being held and repeats */
+
+/** 
+ * structure that holds a key event. Used by the event queue
+ */
+typedef struct {
+	uint8_t key; /**< Index of the key: row * coln + col. The character is keyMap[key] */
+	uint8_t type; /**< Type of the event: MATRIXKEYPAD_EVENT_PRESS, MATRIXKEYPAD_EVENT_RELEASE, MATRIXKEYPAD_EVENT_HOLD or MATRIXKEYPAD_EVENT_REPEAT */
+	uint16_t time; /**< Lower 16 bits of millis() when the scan detected the event. Subtract two times as uint16_t to get the elapsed time */
+} MatrixKeypad_event_t;
+#endif
+
+/** 
+ * Tells if more than "timeout" ticks of millis() or micros() passed from "start" to "now". The unsigned subtraction is right even if the clock wrapped around.
+ * Used by the timeout waits of the C functions and of the C++ template.
+ */
+#define MATRIXKEYPAD_TIMED_OUT(start, now, timeout) ((uint32_t)((uint32_t)(now) - (uint32_t)(start)) > (uint32_t)(timeout))
+
+#if MATRIXKEYPAD_TRANSPORT
+/** 
+ * structure that holds the functions that access the keypad hardware. Used instead of the row and column pins by the keypads initialized with MatrixKeypad_initTransport
+ * The functions work on a whole row strobe and a whole column word, so a backend can use a single bus transaction for each one.
+ * A backend whose hardware scans the rows by itself (DMA, PIO) only sets "begin" and "readFrame".
+ */
+typedef struct {
+	void (*begin)(void *context); /**< Configures the hardware, leaving the rows released. Called by MatrixKeypad_begin */
+	void (*selectRow)(void *context, uint8_t row); /**< Strobes the row "row" and releases the others */
+	void (*releaseRows)(void *context); /**< Releases the rows at the end of a frame */
+	MatrixKeypad_cols_t (*readCols)(void *context); /**< Reads the columns of the strobed row. Returns a word with the bit "C" set if the key at column "C" is pressed */
+	uint8_t (*probe)(void *context); /**< Returns 0 if no key is pressed, so the frame is skipped, or 1 if a key may be pressed. Can be NULL */
+	void (*readFrame)(void *context, MatrixKeypad_cols_t *frame); /**< Copies the last frame scanned by the hardware to "frame", one column word for each row. Can be NULL. If set, the rows aren't strobed by the library and the other functions but "begin" aren't called */
+	void *context; /**< State of the backend, passed to the functions */
+	uint8_t rown; /**< Number of rows of the backend hardware, or 0 if the backend doesn't limit them. The keypad must have the same number of rows */
+	uint8_t coln; /**< Number of columns of the backend hardware, or 0 if the backend doesn't limit them. The keypad must have the same number of columns */
+} MatrixKeypad_transport_t;
+#endif
+
+#if MATRIXKEYPAD_USE_PORTS
+/** 
+ * structure that holds a pin resolved to its port register and bit mask. Used by the direct port register backend
+ */
+typedef struct {
+	volatile uint8_t *reg; /**< Port register of the pin. Is the output register (PORTx) for the rows and the input register (PINx) for the columns */
+	uint8_t mask; /**< Bit mask of the pin inside the port register */
+} MatrixKeypad_pin_t;
+
+/** 
+ * structure that holds the columns that are connected to the same port. Used by the direct port register backend to read all of them with a single load
+ */
+typedef struct {
+	volatile uint8_t *reg; /**< Input register (PINx) of the port */
+	uint8_t mask; /**< Bits of the port that are connected to columns */
+	uint8_t cols[8]; /**< Column index connected to each bit of the port. Only the entries of the bits set in "mask" are valid */
+} MatrixKeypad_portGroup_t;
+
+#endif
+
+#if MATRIXKEYPAD_STATS
+/** 
+ * structure that holds the scan instrumentation counters. The times are measured with micros() and millis()
+ */
+typedef struct {
+	uint32_t scans; /**< Number of frames completed */
+	uint32_t totalTime; /**< Sum of the durations of the frames, in microseconds */
+	uint32_t averageTime; /**< Average duration of a frame, in microseconds. Only filled by MatrixKeypad_getStats */
+	uint32_t worstTime; /**< Longest duration of a frame, in microseconds */
+	uint32_t maxGap; /**< Longest time between the start of two frames, in microseconds */
+	uint16_t overwrites; /**< Number of unread keys overwritten by a new key */
+	uint16_t drops; /**< Number of keys or events dropped because the queue was full */
+	uint16_t latency[MATRIXKEYPAD_STATS_BUCKETS]; /**< Histogram of the time from the detection of a key press to its read. The bucket 0 counts less than 1ms and the bucket "B" from 2^(B-1) to 2^B - 1 ms */
+} MatrixKeypad_stats_t;
+#endif
+
+#if MATRIXKEYPAD_CALLBACKS
+struct MatrixKeypad_s;
+
+/** 
+ * function called when a key is pressed or released. Receives the keypad and the character of the key in the key mapping
+ */
+typedef void (*MatrixKeypad_callback_t)(struct MatrixKeypad_s *keypad, char key);
+#endif
+
+/** 
+ * structure that holds the constant description of a keypad: the pin mappings, the key mapping and the dimensions.
+ * Keypads wired the same way can share one layout. With MATRIXKEYPAD_PROGMEM it must be declared with PROGMEM on AVR, like the mappings.
  */
 typedef struct {
+	const uint8_t *rowPins; /**< Pin mapping for the rows. The same of MatrixKeypad_create */
+	const uint8_t *colPins; /**< Pin mapping for the columns. The same of MatrixKeypad_create */
+	const char *keyMap; /**< Key mapping for the keypad. The same of MatrixKeypad_create */
 	uint8_t rown; /**< Number of rows. Must be greater than zero */
 	uint8_t coln; /**< Number of columns. Must be greater than zero */
-	uint8_t *rowPins; /**< Pin mapping for the rows. These pins are set as output. Is a unidimentional matrix with length = "rown" */
-	uint8_t *colPins; /**< Pin mapping for the columns. These pins are set as inputs. Is a unidimentional matrix with length = "coln" */
-	char *keyMap; /**< Key mapping for the keypad. Its a bidimentional matrix with "rown" rows and "coln" columns. When a keypress is detect at row R and column C, the returned key is the one at keyMap[R][C]. The key mapping is directly related to the pin mappings. Dont use '\0' as a mapped key  */
+} MatrixKeypad_layout_t;
+
+/** 
+ * structure that holds the physical parameters of the keypad, the pin mapping, the key mapping and the state variables
+ */
+typedef struct MatrixKeypad_s {
+#if MATRIXKEYPAD_COMPACT
+	const MatrixKeypad_layout_t *layout; /**< Pin mappings, key mapping and dimensions of the keypad. Can be shared by several keypads */
+#else
+	const uint8_t *rowPins; /**< Pin mapping for the rows. These pins are set as output. Is a unidimentional matrix with length = "rown" */
+	const uint8_t *colPins; /**< Pin mapping for the columns. These pins are set as inputs. Is a unidimentional matrix with length = "coln" */
+	const char *keyMap; /**< Key mapping for the keypad. Its a bidimentional matrix with "rown" rows and "coln" columns. When a keypress is detect at row R and column C, the returned key is the one at keyMap[R][C]. The key mapping is directly related to the pin mappings. Dont use '\0' as a mapped key  */
+	uint8_t rown; /**< Number of rows. Must be greater than zero */
+	uint8_t coln; /**< Number of columns. Must be greater than zero */
+	uint8_t allocated; /**< 1 if the keypad was allocated by MatrixKeypad_create, so MatrixKeypad_destroy releases its memory */
+#endif
 	char lastKey; /**< Holds the last key detected. Used to avoid the same keypress to be read multiple times */
-	char buffer; /**< Holds the last key accepted. Is cleared after the keypress is requested. Its overwritten if a new key is pressed before the old one is requested */
+	volatile char buffer; /**< Holds the last key accepted. Is cleared after the keypress is requested. Its overwritten if a new key is pressed before the old one is requested. With MATRIXKEYPAD_TIMER it isn't cleared, "bufferSeq" and "bufferAck" tell if it was read. Not used when MATRIXKEYPAD_QUEUE_SIZE is greater than zero */
+#if MATRIXKEYPAD_USE_STEP
+	uint16_t scanIndex; /**< Index of the first key of the row "scanRow" (scanRow * coln), so the scan doesn't multiply */
+	uint8_t scanRow; /**< Next row to be scanned by MatrixKeypad_step or MatrixKeypad_tick. 0 when no frame is in progress */
+	char frameKey; /**< Key detected by the rows already scanned in the current frame */
+#endif
+#if MATRIXKEYPAD_TRANSPORT
+	const MatrixKeypad_transport_t *transport; /**< Transport that accesses the hardware or NULL if the keypad uses the row and column pins */
+#endif
+#if MATRIXKEYPAD_INDEX
+	const void *lookup; /**< Lookup table with one value for each key index or NULL */
+	uint8_t lookupSize; /**< Size in bytes of each value of "lookup": 1, 2 or 4 */
+#endif
+#if MATRIXKEYPAD_USE_PORTS
+	MatrixKeypad_pin_t rowPorts[MATRIXKEYPAD_MAX_ROWS]; /**< Row pins resolved to their port registers. Filled by MatrixKeypad_create */
+	MatrixKeypad_pin_t colPorts[MATRIXKEYPAD_MAX_COLS]; /**< Column pins resolved to their port registers. Filled by MatrixKeypad_create */
+	volatile uint8_t *rowReg; /**< Output register shared by all the rows or NULL if the rows are on different ports */
+	uint8_t rowMask; /**< Bits of "rowReg" connected to the rows */
+	MatrixKeypad_portGroup_t colGroups[MATRIXKEYPAD_PORT_GROUPS]; /**< Columns grouped by port */
+	uint8_t colGroupn; /**< Number of valid entries in "colGroups" or 0 if the columns use more than MATRIXKEYPAD_PORT_GROUPS ports */
+#endif
+#if MATRIXKEYPAD_MULTIKEY
+	MatrixKeypad_cols_t raw[MATRIXKEYPAD_MAX_ROWS]; /**< Frame being scanned. One word for each row with the bit "C" set if the key at column "C" is pressed */
+	MatrixKeypad_cols_t state[MATRIXKEYPAD_MAX_ROWS]; /**< Keys pressed in the last complete frame, same layout of "raw" */
+	MatrixKeypad_cols_t changes[MATRIXKEYPAD_MAX_ROWS]; /**< Keys that changed in the last complete frame (XOR of the last two frames). A bit set in "changes" and "state" is a press, set only in "changes" is a release */
+#endif
+#if MATRIXKEYPAD_DEBOUNCE
+	MatrixKeypad_cols_t counters[MATRIXKEYPAD_DEBOUNCE_BITS][MATRIXKEYPAD_MAX_ROWS]; /**< Vertical debounce counters. The bit "C" of counters[B][R] is the bit "B" of the counter of the key at row "R" and column "C" */
+	uint8_t debounceCount; /**< Number of consecutive frames a key must read the same to change its debounced state */
+#endif
+#if MATRIXKEYPAD_GHOST
+	uint8_t ghosted; /**< 1 if the last complete frame had ambiguous keys */
+#endif
+#if MATRIXKEYPAD_REPEAT
+	uint16_t repeatDelay; /**< Time in milliseconds a key must be held before it repeats. 0 if the repeat is disabled */
+	uint16_t repeatInterval; /**< Time in milliseconds between two repeats. 0 if the repeat is disabled */
+	uint16_t holdTime; /**< Time in milliseconds a key must be held to be a long press. 0 if the hold event is disabled */
+	uint16_t repeatStart; /**< Lower 16 bits of millis() when the repeating key was pressed */
+	uint16_t repeatNext; /**< Lower 16 bits of millis() of the next repeat */
+	uint8_t repeatKey; /**< Index of the last key pressed, the one that repeats */
+	uint8_t repeatState; /**< 0 if no key repeats, 1 if "repeatKey" is held or 2 after its hold event */
+#endif
+#if MATRIXKEYPAD_SETTLE
+	uint8_t settleTime; /**< Time in microseconds the scan waits after strobing a row */
+#endif
+#if MATRIXKEYPAD_ADAPTIVE
+	uint16_t activeInterval; /**< Scan interval of MatrixKeypad_poll while a key is pressed, in milliseconds */
+	uint16_t idleInterval; /**< Scan interval of MatrixKeypad_poll while no key is pressed, in milliseconds */
+	uint32_t lastScan; /**< Time of the last scan of MatrixKeypad_poll */
+	uint8_t active; /**< 1 if a key was pressed in the last complete frame */
+#endif
+#if MATRIXKEYPAD_TIMER
+	volatile uint8_t timed; /**< 1 while the keypad is scanned by the timer interrupt */
+#endif
+#if MATRIXKEYPAD_USE_QUEUE
+#if MATRIXKEYPAD_EVENTS
+	MatrixKeypad_event_t queue[MATRIXKEYPAD_QUEUE_SIZE]; /**< Ring buffer of the events detected and not read yet */
+#else
+	char queue[MATRIXKEYPAD_QUEUE_SIZE]; /**< Ring buffer of the keys accepted and not read yet */
+#endif
+	volatile uint8_t queueHead; /**< Number of keys added to the queue. Only written by the scan */
+	volatile uint8_t queueTail; /**< Number of keys removed from the queue. Only written by the reading functions */
+	volatile uint16_t overflows; /**< Number of keys dropped because the queue was full */
+#elif MATRIXKEYPAD_USE_SEQ
+	volatile uint8_t bufferSeq; /**< Incremented each time a key is saved in "buffer" */
+	uint8_t bufferAck; /**< Value of "bufferSeq" when "buffer" was last read */
+#endif
+#if MATRIXKEYPAD_CALLBACKS
+	MatrixKeypad_callback_t onPress; /**< Called when a key is pressed or NULL */
+	MatrixKeypad_callback_t onRelease; /**< Called when a key is released or NULL */
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+	volatile uint8_t pending; /**< Set by the scan when a key changed. Cleared by MatrixKeypad_dispatch */
+#if MATRIXKEYPAD_MULTIKEY
+	volatile MatrixKeypad_cols_t pressLatch[MATRIXKEYPAD_MAX_ROWS]; /**< Keys pressed since the last dispatch, same layout of "state" */
+	MatrixKeypad_cols_t reported[MATRIXKEYPAD_MAX_ROWS]; /**< Keys whose press was dispatched and whose release wasn't, same layout of "state" */
+#else
+	volatile char pressLatch; /**< Last key pressed since the last dispatch or '\0' */
+	char reported; /**< Key whose press was dispatched and whose release wasn't or '\0' */
+#endif
+#endif
+#endif
+#if MATRIXKEYPAD_STATS
+	MatrixKeypad_stats_t stats; /**< Scan instrumentation counters */
+	uint32_t statsStart; /**< Start of the frame in progress, in microseconds */
+	uint32_t statsLast; /**< Start of the last complete frame, in microseconds */
+	uint32_t statsBusy; /**< Time spent by the calls of MatrixKeypad_step or MatrixKeypad_tick of the frame in progress, in microseconds */
+#if MATRIXKEYPAD_USE_QUEUE && !MATRIXKEYPAD_EVENTS
+	uint16_t queueTime[MATRIXKEYPAD_QUEUE_SIZE]; /**< Lower 16 bits of millis() when each key of "queue" was detected */
+#elif !MATRIXKEYPAD_USE_QUEUE
+	volatile uint16_t bufferTime; /**< Lower 16 bits of millis() when the key of "buffer" was detected */
+#endif
+#endif
+#if MATRIXKEYPAD_INTERRUPTS
+	uint8_t idleMode; /**< 1 if the idle mode is enabled */
+	volatile uint8_t armed; /**< 1 while the rows are held LOW waiting for a column interrupt */
+	volatile uint8_t wake; /**< Set by the column interrupt. Tells MatrixKeypad_scan that a key was pressed while idle */
+	struct MatrixKeypad_s *nextIdle; /**< Next keypad in idle mode. Used by MatrixKeypad_wakeFromISR */
+#if MATRIXKEYPAD_USE_NOTIFY
+	void * volatile waitTask; /**< Task blocked in a wait function or the scan task, notified by the column interrupt. NULL if none */
+#endif
+#endif
+#if MATRIXKEYPAD_USE_RTOS
+	TaskHandle_t volatile task; /**< Handle of the scan task or NULL if it isn't running */
+	volatile uint8_t taskRun; /**< Cleared by MatrixKeypad_stopTask to end the scan task */
+	volatile uint8_t taskDone; /**< Set by the scan task when it leaves its loop. The task is then deleted by MatrixKeypad_stopTask */
+	TickType_t taskInterval; /**< Ticks between two scans of the scan task */
+	QueueHandle_t subscribers[MATRIXKEYPAD_RTOS_SUBSCRIBERS]; /**< Queues that receive the keys from the scan task */
+	volatile uint8_t subscribern; /**< Number of valid entries in "subscribers" */
+#endif
 } MatrixKeypad_t;
 
+#if MATRIXKEYPAD_GROUP
+/** 
+ * structure that holds a group of keypads that share the row pins
+ */
+typedef struct {
+	MatrixKeypad_t **keypads; /**< Keypads of the group. The first one drives the rows */
+	uint8_t keypadn; /**< Number of keypads. Must be greater than zero */
+} MatrixKeypad_group_t;
+#endif
+
+/** 
+ * Static initializer of a keypad object. Allows the keypad to be allocated statically, without MatrixKeypad_create. Not available with MATRIXKEYPAD_COMPACT.
+ * The pins are not configured by the initializer. You must call MatrixKeypad_begin inside the "setup()" function before using the keypad.
+ * 
+@code{.c}
+MatrixKeypad_t keypad = MATRIXKEYPAD_INITIALIZER((char*)keymap, rowPins, colPins, rown, coln);
+
+void setup() {
+	MatrixKeypad_begin(&keypad);
+}
+@endcode 
+ * 
+ * @param keymap Key mapping for the keypad. The same of MatrixKeypad_create.
+ * @param rowPins Pin mapping for the rows. The same of MatrixKeypad_create.
+ * @param colPins Pin mapping for the columns. The same of MatrixKeypad_create.
+ * @param rown Number of rows. Must be greater than zero.
+ * @param coln Number of columns. Must be greater than zero.
+ * @since 1.2.0
+ */
+#if !MATRIXKEYPAD_COMPACT
+#define MATRIXKEYPAD_INITIALIZER(keymap, rowPins, colPins, rown, coln) { (rowPins), (colPins), (keymap), (rown), (coln) }
+#endif
+
+/** 
+ * Static initializer of a keypad layout (MatrixKeypad_layout_t). The layout is constant, so it stays in the flash on the ARM and ESP32 cores
+ * and, declared with PROGMEM and MATRIXKEYPAD_PROGMEM, on AVR.
+ * 
+@code{.c}
+const MatrixKeypad_layout_t layout PROGMEM = MATRIXKEYPAD_LAYOUT_INITIALIZER((const char*)keymap, rowPins, colPins, rown, coln);
+@endcode 
+ * 
+ * @param keymap Key mapping for the keypad. The same of MatrixKeypad_create.
+ * @param rowPins Pin mapping for the rows. The same of MatrixKeypad_create.
+ * @param colPins Pin mapping for the columns. The same of MatrixKeypad_create.
+ * @param rown Number of rows. Must be greater than zero.
+ * @param coln Number of columns. Must be greater than zero.
+ * @since 1.2.0
+ */
+#define MATRIXKEYPAD_LAYOUT_INITIALIZER(keymap, rowPins, colPins, rown, coln) { (rowPins), (colPins), (keymap), (rown), (coln) }
+
+#if MATRIXKEYPAD_COMPACT
+/** 
+ * Static initializer of a keypad object that uses a layout. Requires MATRIXKEYPAD_COMPACT.
+ * Several keypads can share the same layout. You must call MatrixKeypad_begin inside the "setup()" function before using the keypads.
+ * 
+@code{.c}
+MatrixKeypad_t keypads[8] = {MATRIXKEYPAD_COMPACT_INITIALIZER(&layouts[0]), MATRIXKEYPAD_COMPACT_INITIALIZER(&layouts[1]), ...};
+@endcode 
+ * 
+ * @param layout The layout of the keypad. Must live while the keypad is used.
+ * @since 1.2.0
+ */
+#define MATRIXKEYPAD_COMPACT_INITIALIZER(layout) { (layout) }
+#endif
+
+#if !MATRIXKEYPAD_COMPACT
 /** 
  * Creates a keypad object that represents the physical keypad and the pin mappings
  * 
@@ -74,6 +375,7 @@ typedef struct {
  * To create the key mapping, define a bidimentional array and initialize with the character to be returned when the key on it's place is pressed.
  * Note that the key mapping ordering is directly related to the pin mapping ordering.
  * The library don't make a copy of mappings to use less storage. The library references the mappings defined in the main sketch, so they can't be reporpused or edited.
+ * With MATRIXKEYPAD_PROGMEM, the mappings are read from the flash memory on AVR and must be declared with PROGMEM, like "const char keymap[rown][coln] PROGMEM".
  * 
  * As an example, consider a 4x3 keypad:
  * 
@@ -95,10 +397,161 @@ MatrixKeypad_t *keypad = MatrixKeypad_create((char*)keymap, rowPins, colPins, ro
  * @param colPins Pin mapping for the columns. Is a unidimentional matrix with length "coln".
  * @param rown Number of rows. Must be greater than zero.
  * @param coln Number of columns. Must be greater than zero.
- * @return A pointer to the structure representing the keypad.
+ * @return A pointer to the structure representing the keypad or NULL if it couldn't be created. When the direct port register backend or the multiple keys scan are enabled, the keypad can't have more than MATRIXKEYPAD_MAX_ROWS rows or MATRIXKEYPAD_MAX_COLS columns.
  * @since 1.0.0
  */
-MatrixKeypad_t *MatrixKeypad_create (char *keymap, uint8_t *rowPins, uint8_t *colPins, uint8_t rown, uint8_t coln);
+MatrixKeypad_t *MatrixKeypad_create (const char *keymap, const uint8_t *rowPins, const uint8_t *colPins, uint8_t rown, uint8_t coln);
+
+/** 
+ * Initializes a keypad object allocated by the caller. Is the same as MatrixKeypad_create, but doesn't use dynamic memory allocation.
+ * The keypad can be a global variable, so it lives in the .bss section and the heap allocator isn't linked to the sketch.
+ * 
+@code{.c}
+MatrixKeypad_t keypad; //global variable
+
+void setup() {
+	MatrixKeypad_init(&keypad, (char*)keymap, rowPins, colPins, rown, coln);
+}
+@endcode 
+ * 
+ * @param keypad The keypad object to be initialized.
+ * @param keymap Key mapping for the keypad. The same of MatrixKeypad_create.
+ * @param rowPins Pin mapping for the rows. The same of MatrixKeypad_create.
+ * @param colPins Pin mapping for the columns. The same of MatrixKeypad_create.
+ * @param rown Number of rows. Must be greater than zero.
+ * @param coln Number of columns. Must be greater than zero.
+ * @return The "keypad" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_t *MatrixKeypad_init (MatrixKeypad_t *keypad, const char *keymap, const uint8_t *rowPins, const uint8_t *colPins, uint8_t rown, uint8_t coln);
+#endif
+
+/** 
+ * Initializes a keypad object allocated by the caller from a layout. Is the same as MatrixKeypad_init, with the mappings and the dimensions taken from the layout.
+ * With MATRIXKEYPAD_COMPACT the keypad keeps a pointer to the layout instead of a copy of the mappings, so the layout must live while the keypad is used.
+ * 
+@code{.c}
+const MatrixKeypad_layout_t layout = MATRIXKEYPAD_LAYOUT_INITIALIZER((const char*)keymap, rowPins, colPins, rown, coln);
+MatrixKeypad_t keypad;
+
+void setup() {
+	MatrixKeypad_initLayout(&keypad, &layout);
+}
+@endcode 
+ * 
+ * @param keypad The keypad object to be initialized.
+ * @param layout The layout of the keypad. With MATRIXKEYPAD_PROGMEM, it must be declared with PROGMEM on AVR.
+ * @return The "keypad" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_t *MatrixKeypad_initLayout (MatrixKeypad_t *keypad, const MatrixKeypad_layout_t *layout);
+
+#if MATRIXKEYPAD_TRANSPORT && !MATRIXKEYPAD_COMPACT
+/** 
+ * Initializes a keypad object that accesses the hardware through a transport instead of the row and column pins.
+ * The transport is configured by MatrixKeypad_begin. See MatrixKeypad_transport.h for the shift register and I2C expander backends.
+ * The idle interrupt modes aren't available for these keypads.
+ * Requires MATRIXKEYPAD_TRANSPORT.
+ * 
+@code{.c}
+MatrixKeypad_t keypad;
+MatrixKeypad_shift_t shift;
+MatrixKeypad_transport_t transport;
+
+void setup() {
+	MatrixKeypad_initShift(&transport, &shift, 10, 9, rown, coln);
+	MatrixKeypad_initTransport(&keypad, (char*)keymap, &transport, rown, coln);
+}
+@endcode 
+ * 
+ * @param keypad The keypad object to be initialized.
+ * @param keymap Key mapping for the keypad. The same of MatrixKeypad_create.
+ * @param transport The transport. Must live while the keypad is used.
+ * @param rown Number of rows. Must be greater than zero, up to MATRIXKEYPAD_MAX_ROWS and the same of the transport, if it tells its dimensions.
+ * @param coln Number of columns. Must be greater than zero, up to MATRIXKEYPAD_MAX_COLS and the same of the transport, if it tells its dimensions.
+ * @return The "keypad" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_t *MatrixKeypad_initTransport (MatrixKeypad_t *keypad, const char *keymap, const MatrixKeypad_transport_t *transport, uint8_t rown, uint8_t coln);
+#endif
+
+/** 
+ * Configures the pins and resets the state of a keypad object.
+ * Is called by MatrixKeypad_create, MatrixKeypad_init and MatrixKeypad_initLayout. You only need to call it for the keypads defined with MATRIXKEYPAD_INITIALIZER or MATRIXKEYPAD_COMPACT_INITIALIZER.
+ * 
+ * @param keypad The keypad object.
+ * @return 1 if the keypad was configured or 0 if its parameters are invalid.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_begin (MatrixKeypad_t *keypad);
+
+#if !MATRIXKEYPAD_COMPACT
+/** 
+ * Changes the key mapping of a keypad, for example to switch between layers or languages. The pins and the state are kept.
+ * The keys already in the buffer keep the character of the old mapping, unless MATRIXKEYPAD_INDEX is enabled. The events (MATRIXKEYPAD_EVENTS) use the key index, so they don't depend on the mapping.
+ * 
+@code{.c}
+const char layers[2][4][3] PROGMEM = {...}; //with MATRIXKEYPAD_PROGMEM
+
+MatrixKeypad_setKeymap(keypad, (const char*)layers[1]);
+@endcode 
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param keymap The new key mapping, with the same dimensions of the old one.
+ * @since 1.2.0
+ */
+void MatrixKeypad_setKeymap (MatrixKeypad_t *keypad, const char *keymap);
+#endif
+
+#if MATRIXKEYPAD_CALLBACKS
+/** 
+ * Sets the functions called when a key is pressed and when it is released. Requires MATRIXKEYPAD_CALLBACKS.
+ * The scan calls them only for the keys that changed, in the same frame that it detects the change. Without MATRIXKEYPAD_MULTIKEY, only the release of the
+ * last key and the press of the new one are seen. The keys are still delivered to MatrixKeypad_getKey, so call MatrixKeypad_flush if they aren't read.
+ * With MATRIXKEYPAD_DEFERRED_CALLBACKS, the functions are called by MatrixKeypad_dispatch instead of the scan.
+ * 
+@code{.c}
+void pressed(MatrixKeypad_t *keypad, char key) {
+	Serial.println(key);
+}
+
+MatrixKeypad_setCallbacks(keypad, pressed, NULL);
+@endcode 
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param onPress Function called when a key is pressed or NULL.
+ * @param onRelease Function called when a key is released or NULL.
+ * @since 1.2.0
+ */
+void MatrixKeypad_setCallbacks (MatrixKeypad_t *keypad, MatrixKeypad_callback_t onPress, MatrixKeypad_callback_t onRelease);
+
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS
+/** 
+ * Calls the callbacks of the keys that changed since the last call. Requires MATRIXKEYPAD_DEFERRED_CALLBACKS.
+ * Call it in each iteration of "loop()". If no key changed, it returns after checking a flag, so the scan can run in an interrupt and the callbacks in "loop()".
+ * 
+@code{.c}
+void loop() {
+	MatrixKeypad_dispatch(keypad); //the timer interrupt scans the keypad
+}
+@endcode 
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return 1 if a key changed since the last call or 0 otherwise.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_dispatch (MatrixKeypad_t *keypad);
+#endif
+#endif
+
+/** 
+ * Stops the timer, the task and the idle mode of a keypad and releases the memory of a keypad object returned by MatrixKeypad_create.
+ * The memory of the keypads initialized by MatrixKeypad_init, MatrixKeypad_initLayout or the static initializers belongs to the caller and isn't released.
+ * 
+ * @param keypad The keypad object. Can be NULL.
+ * @since 1.2.0
+ */
+void MatrixKeypad_destroy (MatrixKeypad_t *keypad);
 
 /** 
  * Scans the keypad to check if a key is currently pressed.
@@ -119,6 +572,107 @@ if((millis() - lastScan) >= 100) {
  */
 void MatrixKeypad_scan (MatrixKeypad_t *keypad);
 
+#if MATRIXKEYPAD_USE_STEP
+/** 
+ * Scans the next row of the keypad. When the last row is scanned, the frame is complete and the keys are saved like MatrixKeypad_scan.
+ * The scan of the keypad is spread over "rown" calls, so each call has a small and bounded cost. Call it once per iteration of "loop()".
+ * The row stays strobed until the next call, so the pins have time to settle.
+ * A call to MatrixKeypad_scan in the middle of a frame discards it and scans the whole keypad.
+ * With MATRIXKEYPAD_COMPACT, requires MATRIXKEYPAD_TIMER or MATRIXKEYPAD_GROUP.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return 1 if the call completed a frame or 0 otherwise.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_step (MatrixKeypad_t *keypad);
+#endif
+
+/** 
+ * Scans the keypads of an array, like a call of MatrixKeypad_scan for each one.
+ * The neighbours of the array that share their rows (the same layout, or the same row pin mapping and number of rows) are scanned together,
+ * like MatrixKeypad_scanGroup: each row is strobed once and the columns of all of them are read. Put the keypads that share a layout next to each other.
+ * The keypads that use a transport, the timer or the idle mode are scanned on their own.
+ * Without MATRIXKEYPAD_MULTIKEY, the compact keypads are also scanned on their own, unless MATRIXKEYPAD_TIMER or MATRIXKEYPAD_GROUP is enabled.
+ * 
+@code{.c}
+MatrixKeypad_t keypads[8];
+
+void loop() {
+	MatrixKeypad_scanArray(keypads, 8);
+}
+@endcode 
+ * 
+ * @param keypads The array of keypads.
+ * @param keypadn Number of keypads of the array.
+ * @since 1.2.0
+ */
+void MatrixKeypad_scanArray (MatrixKeypad_t *keypads, uint8_t keypadn);
+
+#if MATRIXKEYPAD_GROUP
+/** 
+ * Initializes a group of keypads that share the row pins.
+ * The keypads must have the same number of rows and the same row pins, in the same order, and are initialized as usual (MatrixKeypad_create or MatrixKeypad_init).
+ * The array of keypads is used by the group, so it must not be a local variable.
+ * Requires MATRIXKEYPAD_GROUP.
+ * 
+ * @param group Storage for the group.
+ * @param keypads Array of "keypadn" keypads.
+ * @param keypadn Number of keypads. Must be greater than zero.
+ * @return 1 if the group was initialized or 0 if the keypads don't share the rows or one of them is scanned by the timer or is in the idle mode.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_initGroup (MatrixKeypad_group_t *group, MatrixKeypad_t **keypads, uint8_t keypadn);
+
+/** 
+ * Scans all keypads of a group. Each row is strobed once and the columns of every keypad are read.
+ * Each keypad keeps its own keys, read as usual with MatrixKeypad_hasKey and MatrixKeypad_getKey.
+ * Use it instead of MatrixKeypad_scan. With MATRIXKEYPAD_EARLY_EXIT, all rows are probed together first and, without MATRIXKEYPAD_MULTIKEY, the scan stops once every keypad has a key. The idle mode and the timer can't be used with the keypads of a group: the group isn't scanned while one of its keypads uses them. A frame of MatrixKeypad_step in progress is discarded.
+ * Requires MATRIXKEYPAD_GROUP.
+ * 
+ * @param group The group initialized by MatrixKeypad_initGroup.
+ * @since 1.2.0
+ */
+void MatrixKeypad_scanGroup (MatrixKeypad_group_t *group);
+#endif
+
+#if MATRIXKEYPAD_SETTLE
+/** 
+ * Sets the time the scan waits after strobing a row, before reading the columns.
+ * The default is MATRIXKEYPAD_SETTLE_TIME.
+ * Requires MATRIXKEYPAD_SETTLE.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param time Settle time in microseconds. 0 doesn't wait.
+ * @since 1.2.0
+ */
+void MatrixKeypad_setSettleTime (MatrixKeypad_t *keypad, uint8_t time);
+#endif
+
+#if MATRIXKEYPAD_ADAPTIVE
+/** 
+ * Sets the scan intervals of MatrixKeypad_poll.
+ * The defaults are MATRIXKEYPAD_ACTIVE_INTERVAL and MATRIXKEYPAD_IDLE_INTERVAL.
+ * Requires MATRIXKEYPAD_ADAPTIVE.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param active Scan interval in milliseconds while a key is pressed.
+ * @param idle Scan interval in milliseconds while no key is pressed.
+ * @since 1.2.0
+ */
+void MatrixKeypad_setScanInterval (MatrixKeypad_t *keypad, uint16_t active, uint16_t idle);
+
+/** 
+ * Scans the keypad if the scan interval has elapsed since the last scan. Call it in every iteration of "loop()" instead of MatrixKeypad_scan.
+ * The interval is short while a key is pressed and long while the keypad is idle (MatrixKeypad_setScanInterval).
+ * Requires MATRIXKEYPAD_ADAPTIVE.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return 1 if the keypad was scanned or 0 if it wasn't time yet.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_poll (MatrixKeypad_t *keypad);
+#endif
+
 /** 
  * Checks if a keypress was detected.
  * 
@@ -129,7 +683,7 @@ void MatrixKeypad_scan (MatrixKeypad_t *keypad);
 uint8_t MatrixKeypad_hasKey (MatrixKeypad_t *keypad);
 
 /** 
- * Returns the last key pressed.
+ * Returns the last key pressed. With MATRIXKEYPAD_QUEUE_SIZE greater than zero, returns the oldest unread key instead.
  * This function is NON-BLOCKING. It won't scan the keyboard for new events or wait for a event.
  * You must use the MatrixKeypad_scan function to scan the keypad periodically.
  * 
@@ -139,10 +693,57 @@ uint8_t MatrixKeypad_hasKey (MatrixKeypad_t *keypad);
  */
 char MatrixKeypad_getKey (MatrixKeypad_t *keypad);
 
+#if MATRIXKEYPAD_INDEX
+/** 
+ * Returns the index of the last key pressed, like MatrixKeypad_getKey but without reading the key mapping. The index of the key at row R and column C is R * coln + C.
+ * The index can select an entry of a jump table or of a lookup table (MatrixKeypad_lookup).
+ * Requires MATRIXKEYPAD_INDEX.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return The index of the pressed key or MATRIXKEYPAD_NO_KEY if none key was pressed.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_getKeyIndex (MatrixKeypad_t *keypad);
+
+/** 
+ * Attaches a lookup table to a keypad. The table has one value for each key index, so the keys can be mapped to values that don't fit a character, like HID usage codes or command ids.
+ * With MATRIXKEYPAD_PROGMEM, the table must be in the flash memory on AVR, like the key mapping.
+ * Requires MATRIXKEYPAD_INDEX.
+ * 
+@code{.c}
+const uint16_t usages[4 * 3] = {0x1E, 0x1F, 0x20, ...};
+
+MatrixKeypad_setLookup(keypad, usages, sizeof(usages[0]));
+send(MatrixKeypad_lookup(keypad, MatrixKeypad_getKeyIndex(keypad)));
+@endcode 
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param table Array of "rown" * "coln" values of type uint8_t, uint16_t or uint32_t, or NULL to detach the table.
+ * @param size Size in bytes of each value: 1, 2 or 4.
+ * @return 1 if the table was attached or 0 if the size is invalid.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_setLookup (MatrixKeypad_t *keypad, const void *table, uint8_t size);
+
+/** 
+ * Returns the value of the lookup table for a key index.
+ * Requires MATRIXKEYPAD_INDEX.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param index The key index, as returned by MatrixKeypad_getKeyIndex.
+ * @return The value of the key or 0 if the keypad has no table or the index isn't valid (MATRIXKEYPAD_NO_KEY, for example).
+ * @since 1.2.0
+ */
+uint32_t MatrixKeypad_lookup (MatrixKeypad_t *keypad, uint8_t index);
+#endif
+
 /** 
  * Waits until a key is pressed and returns it.
  * If there is a unread event in the buffer, that event is returned instead.
  * This function is BLOCKING. The program will freeze until a key press is detected.
+ * With MATRIXKEYPAD_WAIT_SLEEP, the cpu sleeps (or the task blocks) between the scans instead of busy waiting.
+ * With MATRIXKEYPAD_DEEP_SLEEP, the keypad is in the idle mode during the wait and the core enters its deepest sleep while all keys are released.
+ * The idle mode is restored before the function returns.
  * 
  * @param keypad The keypad object returned by MatrixKeypad_create.
  * @return The pressed key character from the key mapping.
@@ -154,6 +755,7 @@ char MatrixKeypad_waitForKey (MatrixKeypad_t *keypad);
  * Waits until a key is pressed and returns it.
  * If there is a unread event in the buffer, that event is returned instead.
  * This function is BLOCKING. The program will freeze until a key press is detected or it timeouts.
+ * With MATRIXKEYPAD_WAIT_SLEEP, the cpu sleeps (or the task blocks) between the scans instead of busy waiting.
  * 
  * @param keypad The keypad object returned by MatrixKeypad_create.
  * @param timeout Maximum time in milliseconds to wait for a event.
@@ -163,7 +765,28 @@ char MatrixKeypad_waitForKey (MatrixKeypad_t *keypad);
 char MatrixKeypad_waitForKeyTimeout (MatrixKeypad_t *keypad, uint16_t timeout);
 
 /** 
- * Cleans the unread keys buffer.
+ * Waits until a key is pressed or a timeout occurs and returns it. Same as MatrixKeypad_waitForKeyTimeout, with a 32 bit timeout.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param timeout Maximum time in milliseconds to wait for a event.
+ * @return The pressed key character from the key mapping or '\0' if a timeout occurs.
+ * @since 1.2.0
+ */
+char MatrixKeypad_waitForKeyTimeoutMillis (MatrixKeypad_t *keypad, uint32_t timeout);
+
+/** 
+ * Waits until a key is pressed or a timeout occurs and returns it. Same as MatrixKeypad_waitForKeyTimeout, with the timeout in microseconds.
+ * The clock is read once per scan, so the timeout is only as precise as the scan time. With MATRIXKEYPAD_WAIT_SLEEP, it is also limited by the sleep between the scans.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param timeout Maximum time in microseconds to wait for a event. Must be lower than 2^31 (about 35 minutes).
+ * @return The pressed key character from the key mapping or '\0' if a timeout occurs.
+ * @since 1.2.0
+ */
+char MatrixKeypad_waitForKeyTimeoutMicros (MatrixKeypad_t *keypad, uint32_t timeout);
+
+/** 
+ * Cleans the unread keys buffer (or the queue).
  * You can use this function to flush the queued keypresses that weren't read by MatrixKeypad_getKey.
  * 
  * @param keypad The keypad object returned by MatrixKeypad_create.
@@ -171,6 +794,303 @@ char MatrixKeypad_waitForKeyTimeout (MatrixKeypad_t *keypad, uint16_t timeout);
  */
 void MatrixKeypad_flush (MatrixKeypad_t *keypad);
 
+#if MATRIXKEYPAD_MULTIKEY
+/** 
+ * Checks if the key at a row and column is pressed in the last complete scan.
+ * With MATRIXKEYPAD_DEBOUNCE, this and the following functions return the debounced state.
+ * Requires MATRIXKEYPAD_MULTIKEY.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param row Row of the key.
+ * @param col Column of the key.
+ * @return 1 if the key is pressed or 0 if it isn't.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_isPressed (MatrixKeypad_t *keypad, uint8_t row, uint8_t col);
+
+/** 
+ * Checks if a key is pressed in the last complete scan. Can be used to detect modifiers and chords.
+ * 
+@code{.c}
+if(MatrixKeypad_isKeyPressed(keypad, '*') && MatrixKeypad_isKeyPressed(keypad, '#')) {
+	//both keys are pressed
+}
+@endcode 
+ * 
+ * Requires MATRIXKEYPAD_MULTIKEY.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param key The key character from the key mapping.
+ * @return 1 if the key is pressed or 0 if it isn't.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_isKeyPressed (MatrixKeypad_t *keypad, char key);
+
+/** 
+ * Returns the number of keys pressed in the last complete scan.
+ * Requires MATRIXKEYPAD_MULTIKEY.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return The number of keys pressed.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_getPressedCount (MatrixKeypad_t *keypad);
+
+/** 
+ * Returns the keys of a row pressed in the last complete scan.
+ * Requires MATRIXKEYPAD_MULTIKEY.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param row The row.
+ * @return A word with the bit "C" set if the key at the column "C" is pressed.
+ * @since 1.2.0
+ */
+MatrixKeypad_cols_t MatrixKeypad_getRowState (MatrixKeypad_t *keypad, uint8_t row);
+
+/** 
+ * Returns the keys of a row that changed in the last complete scan.
+ * A bit set in the changes and in the state (MatrixKeypad_getRowState) is a press. A bit set only in the changes is a release.
+ * Requires MATRIXKEYPAD_MULTIKEY.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param row The row.
+ * @return A word with the bit "C" set if the key at the column "C" was pressed or released.
+ * @since 1.2.0
+ */
+MatrixKeypad_cols_t MatrixKeypad_getRowChanges (MatrixKeypad_t *keypad, uint8_t row);
+#endif
+
+#if MATRIXKEYPAD_GHOST
+/** 
+ * Checks if the last complete scan found ghost keys. The ambiguous keys keep the state they had before the ghost appeared,
+ * so a chord read in this frame may be incomplete and can be dropped by the caller.
+ * Requires MATRIXKEYPAD_GHOST.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return 1 if the last frame had ambiguous keys or 0 otherwise.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_isGhosted (MatrixKeypad_t *keypad);
+#endif
+
+#if MATRIXKEYPAD_DEBOUNCE
+/** 
+ * Sets the number of consecutive scans a key must read the same to be accepted as pressed or released.
+ * The debounce latency is "count" times the scan interval. For example, 3 scans each 2ms accept a key after 6ms.
+ * The default is MATRIXKEYPAD_DEBOUNCE_COUNT.
+ * Requires MATRIXKEYPAD_DEBOUNCE.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param count Number of scans, between 1 (no debouncing) and 2^MATRIXKEYPAD_DEBOUNCE_BITS - 1.
+ * @return 1 if the count was set or 0 if it is out of range.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_setDebounce (MatrixKeypad_t *keypad, uint8_t count);
+#endif
+
+#if MATRIXKEYPAD_USE_QUEUE
+/** 
+ * Returns the number of keys in the queue, waiting to be read by MatrixKeypad_getKey.
+ * Requires MATRIXKEYPAD_QUEUE_SIZE greater than zero.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return The number of unread keys.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_getQueueDepth (MatrixKeypad_t *keypad);
+
+/** 
+ * Returns the number of keys dropped because the queue was full.
+ * The counter is only reset by MatrixKeypad_begin. To count the overflows of a period, save the value at the start and subtract it.
+ * Requires MATRIXKEYPAD_QUEUE_SIZE greater than zero.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return The number of dropped keys.
+ * @since 1.2.0
+ */
+uint16_t MatrixKeypad_getOverflowCount (MatrixKeypad_t *keypad);
+#endif
+
+#if MATRIXKEYPAD_EVENTS
+/** 
+ * Reads the oldest event of the queue.
+ * The events are timestamped by the scan that detected them, so the time doesn't depend on when they are read.
+ * MatrixKeypad_hasKey and MatrixKeypad_getKey read the same queue and discard the events that aren't key presses (or repeats, with MATRIXKEYPAD_REPEAT), so use either them or this function.
+ * Requires MATRIXKEYPAD_EVENTS.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param event Receives the event. Isn't changed if the queue is empty.
+ * @return 1 if an event was read or 0 if the queue is empty.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_getEvent (MatrixKeypad_t *keypad, MatrixKeypad_event_t *event);
+
+/** 
+ * Reads up to "max" events of the queue at once, the oldest first. Same as calling MatrixKeypad_getEvent "max" times, but the queue indexes are read and written only once,
+ * so a consumer that runs rarely can pack all pending events in a single report.
+ * Requires MATRIXKEYPAD_EVENTS.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param events Array that receives the events.
+ * @param max Length of "events".
+ * @return The number of events read. 0 if the queue is empty.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_readEvents (MatrixKeypad_t *keypad, MatrixKeypad_event_t *events, uint8_t max);
+#endif
+
+#if MATRIXKEYPAD_REPEAT
+/** 
+ * Sets the auto-repeat and the long press times of a keypad. Only the last key pressed repeats, like in a computer keyboard, so a single timer serves all keys.
+ * After "delay" milliseconds held, the key adds a MATRIXKEYPAD_EVENT_REPEAT event to the queue each "interval" milliseconds, also returned by MatrixKeypad_getKey.
+ * After "hold" milliseconds held, it adds one MATRIXKEYPAD_EVENT_HOLD event. The times are checked once per frame, so they are rounded up to the scan interval.
+ * The defaults are MATRIXKEYPAD_REPEAT_DELAY, MATRIXKEYPAD_REPEAT_INTERVAL and MATRIXKEYPAD_HOLD_TIME.
+ * Requires MATRIXKEYPAD_REPEAT.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param delay Time in milliseconds before the first repeat, up to 32767. 0 disables the repeat.
+ * @param interval Time in milliseconds between two repeats, up to 32767. 0 disables the repeat.
+ * @param hold Time in milliseconds of a long press, up to 32767. 0 disables the hold event.
+ * @since 1.2.0
+ */
+void MatrixKeypad_setRepeat (MatrixKeypad_t *keypad, uint16_t delay, uint16_t interval, uint16_t hold);
+#endif
+
+#if MATRIXKEYPAD_TIMER
+/** 
+ * Starts scanning the keypad in background by a hardware timer interrupt.
+ * Each tick of the timer scans one row, so a complete scan takes "rown" ticks. The row stays strobed between the ticks, which gives the lines time to settle.
+ * While the timer is running, MatrixKeypad_scan does nothing and the keys are read with MatrixKeypad_hasKey, MatrixKeypad_getKey and MatrixKeypad_waitForKey.
+ * Only one keypad can be scanned by the timer. Uses the Timer2 on AVR (the tone function can't be used at the same time) and the esp_timer on ESP32.
+ * Requires MATRIXKEYPAD_TIMER.
+ * 
+@code{.c}
+MatrixKeypad_startTimer(keypad, 5000); //scans a row each 5ms. A 4 rows keypad is scanned each 20ms
+@endcode 
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param period Time between the ticks in microseconds. On AVR at 16MHz it must be between 1us and 16384us.
+ * @return 1 if the timer was started or 0 if the period is invalid, the timer is in use or the core is not supported.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_startTimer (MatrixKeypad_t *keypad, uint32_t period);
+
+/** 
+ * Stops the background scanning by the timer interrupt.
+ * Requires MATRIXKEYPAD_TIMER.
+ * 
+ * @param keypad The keypad object passed to MatrixKeypad_startTimer.
+ * @since 1.2.0
+ */
+void MatrixKeypad_stopTimer (MatrixKeypad_t *keypad);
+
+/** 
+ * Scans the next row of the keypad. Is called by the timer interrupt. Same as MatrixKeypad_step, but also runs while the timer is started.
+ * You only need to call it from your own timer interrupt on the cores not supported by MatrixKeypad_startTimer. In that case, don't call MatrixKeypad_scan or MatrixKeypad_step.
+ * Requires MATRIXKEYPAD_TIMER.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @since 1.2.0
+ */
+void MatrixKeypad_tick (MatrixKeypad_t *keypad);
+#endif
+
+#if MATRIXKEYPAD_USE_RTOS
+/** 
+ * Starts a FreeRTOS task that scans the keypad periodically and posts the keys to the subscriber queues (MatrixKeypad_subscribe).
+ * Each key press is sent as a "char" or, with MATRIXKEYPAD_EVENTS, each event as a MatrixKeypad_event_t, so create the queues with the matching item size.
+ * The items are sent without blocking: if a queue is full, the item is dropped for that queue only.
+ * While the task runs, read the keys from the queues, not with MatrixKeypad_getKey. In idle mode, the task blocks until the column interrupt.
+ * Requires MATRIXKEYPAD_RTOS on ESP32.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param interval Time in milliseconds between two scans.
+ * @param priority Priority of the task.
+ * @param core Core the task is pinned to (0 or 1).
+ * @return 1 if the task was started or 0 if it is already running or can't be created.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_startTask (MatrixKeypad_t *keypad, uint16_t interval, uint8_t priority, uint8_t core);
+
+/** 
+ * Stops the scan task. Returns after the task has ended.
+ * Requires MATRIXKEYPAD_RTOS on ESP32.
+ * 
+ * @param keypad The keypad object passed to MatrixKeypad_startTask.
+ * @since 1.2.0
+ */
+void MatrixKeypad_stopTask (MatrixKeypad_t *keypad);
+
+/** 
+ * Adds a queue that receives the keys posted by the scan task. Can be called while the task is running.
+ * Requires MATRIXKEYPAD_RTOS on ESP32.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param queue The FreeRTOS queue. Its item size must be sizeof(char), or sizeof(MatrixKeypad_event_t) with MATRIXKEYPAD_EVENTS.
+ * @return 1 if the queue was added or 0 if there are already MATRIXKEYPAD_RTOS_SUBSCRIBERS queues.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_subscribe (MatrixKeypad_t *keypad, QueueHandle_t queue);
+#endif
+
+#if MATRIXKEYPAD_INTERRUPTS
+/** 
+ * Enables or disables the interrupt driven idle mode.
+ * When all keys are released, the keypad goes idle: all rows are held LOW and an interrupt is attached to each column pin.
+ * While idle, MatrixKeypad_scan returns immediately without touching the pins. After a column edge, the next MatrixKeypad_scan
+ * restores the rows, scans the keypad as usual and goes idle again once all keys are released.
+ * The column pins must support external interrupts (attachInterrupt) or, on AVR, pin change interrupts.
+ * Requires MATRIXKEYPAD_INTERRUPTS.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param enable 1 to enable or 0 to disable the idle mode.
+ * @since 1.2.0
+ */
+void MatrixKeypad_setIdleMode (MatrixKeypad_t *keypad, uint8_t enable);
+
+/** 
+ * Checks if the keypad is idle, waiting for a column interrupt.
+ * Can be used to decide if the MCU can be put to sleep.
+ * Requires MATRIXKEYPAD_INTERRUPTS.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @return 1 if the keypad is idle or 0 if it must be scanned.
+ * @since 1.2.0
+ */
+uint8_t MatrixKeypad_isIdle (MatrixKeypad_t *keypad);
+
+/** 
+ * Wakes the keypads in idle mode. Is the handler of the column interrupts.
+ * You only need to call it from your own ISR if the library can't define the pin change vectors (MATRIXKEYPAD_PCINT_ISR = 0).
+ * Requires MATRIXKEYPAD_INTERRUPTS.
+ * 
+ * @since 1.2.0
+ */
+void MatrixKeypad_wakeFromISR (void);
+#endif
+
+#if MATRIXKEYPAD_STATS
+/** 
+ * Copies the scan instrumentation counters of a keypad and computes the average frame duration.
+ * The frames of MatrixKeypad_step and MatrixKeypad_tick count only the time spent inside the calls, not the time between them.
+ * Requires MATRIXKEYPAD_STATS.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @param stats Storage for the snapshot of the counters.
+ * @since 1.2.0
+ */
+void MatrixKeypad_getStats (MatrixKeypad_t *keypad, MatrixKeypad_stats_t *stats);
+
+/** 
+ * Clears the scan instrumentation counters of a keypad. They are also cleared by MatrixKeypad_begin.
+ * Requires MATRIXKEYPAD_STATS.
+ * 
+ * @param keypad The keypad object returned by MatrixKeypad_create.
+ * @since 1.2.0
+ */
+void MatrixKeypad_resetStats (MatrixKeypad_t *keypad);
+#endif
+
 #ifdef __cplusplus
 	}
 #endif
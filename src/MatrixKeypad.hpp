@@ -0,0 +1,308 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad.hpp
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Compile time specialized keypad for C++ sketches.
+ *
+ * The dimensions and the pins are template parameters, so the compiler unrolls the scan loops, folds the key mapping
+ * index math and, on the ATmega328P/168 (Uno, Nano, Pro Mini), emits single instruction port operations (cbi, sbi, sbis) for each pin.
+ * The other cores call digitalWrite and digitalRead with constant pins.
+ * A keypad only keeps the key map pointer and the two state variables in RAM.
+ *
+ * The template is a separate minimal API, not a wrapper of the C functions of MatrixKeypad.h: it has its own scan, which behaves as MatrixKeypad_scan
+ * with all the compile options of MatrixKeypad_config.h disabled. The features enabled by the MATRIXKEYPAD_* options (multiple keys, debounce, queue,
+ * events, idle mode, timer and the others) are only available through the C functions.
+ *
+ * As an example, consider the 4x3 keypad of MatrixKeypad_create. The row pins are listed first, then the column pins:
+ *
+@code{.cpp}
+#include "MatrixKeypad.hpp"
+
+const char keymap[4][3] =
+  {{'1','2','3'},
+   {'4','5','6'},
+   {'7','8','9'},
+   {'*','0','#'}};
+MatrixKeypad<4, 3, 10, 9, 8, 7, 6, 5, 4> keypad((const char*)keymap);
+
+void setup() {
+	keypad.begin(); //configures the pins
+}
+
+void loop() {
+	keypad.scan();
+	if(keypad.hasKey()) {
+		Serial.print(keypad.getKey());
+	}
+}
+@endcode
+ *
+ */
+#ifndef MATRIXKEYPAD_HPP
+#define MATRIXKEYPAD_HPP
+
+#include "Arduino.h"
+#include "MatrixKeypad.h"
+#include <stdint.h>
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+	#define MATRIXKEYPAD_CONST_PORTS 1
+#else
+	#define MATRIXKEYPAD_CONST_PORTS 0
+#endif
+
+/* Pin operations with the pin known at compile time. On the ATmega328P the branches are folded to a single port instruction */
+template <uint8_t Pin>
+struct MatrixKeypad_constPin {
+
+#if MATRIXKEYPAD_CONST_PORTS
+	/* pins 0-7 are on PORTD, 8-13 on PORTB and 14-19 (A0-A5) on PORTC */
+	static const uint8_t mask = 1 << (Pin < 8 ? Pin : (Pin < 14 ? Pin - 8 : Pin - 14));
+#endif
+
+	static inline void write (uint8_t level) {
+#if MATRIXKEYPAD_CONST_PORTS
+		if(Pin < 8) {
+			if(level == LOW) PORTD &= ~mask; else PORTD |= mask;
+		}
+		else if(Pin < 14) {
+			if(level == LOW) PORTB &= ~mask; else PORTB |= mask;
+		}
+		else {
+			if(level == LOW) PORTC &= ~mask; else PORTC |= mask;
+		}
+#else
+		digitalWrite(Pin, level);
+#endif
+	}
+
+	static inline uint8_t read () {
+#if MATRIXKEYPAD_CONST_PORTS
+		if(Pin < 8) {
+			return (PIND & mask) ? HIGH : LOW;
+		}
+		else if(Pin < 14) {
+			return (PINB & mask) ? HIGH : LOW;
+		}
+		return (PINC & mask) ? HIGH : LOW;
+#else
+		return digitalRead(Pin);
+#endif
+	}
+};
+
+/* Reads the columns 0 to Col - 1 of the row Row. The recursion unrolls the loop */
+template <class Keypad, uint8_t Row, uint8_t Col>
+struct MatrixKeypad_scanCols {
+
+	static inline char run (const char *keyMap, char key) {
+		key = MatrixKeypad_scanCols<Keypad, Row, Col - 1>::run(keyMap, key);
+		if(MatrixKeypad_constPin<Keypad::pin(Keypad::rows + Col - 1)>::read() == LOW) {
+			key = keyMap[Row * Keypad::cols + Col - 1]; /* the index is a constant */
+		}
+		return key;
+	}
+};
+
+template <class Keypad, uint8_t Row>
+struct MatrixKeypad_scanCols<Keypad, Row, 0> {
+
+	static inline char run (const char *keyMap, char key) {
+		(void)keyMap;
+		return key;
+	}
+};
+
+/* Strobes the rows 0 to Row - 1 and reads their columns. The recursion unrolls the loop */
+template <class Keypad, uint8_t Row>
+struct MatrixKeypad_scanRows {
+
+	static inline char run (const char *keyMap, char key) {
+		key = MatrixKeypad_scanRows<Keypad, Row - 1>::run(keyMap, key);
+		MatrixKeypad_constPin<Keypad::pin(Row - 1)>::write(LOW);
+		key = MatrixKeypad_scanCols<Keypad, Row - 1, Keypad::cols>::run(keyMap, key);
+		MatrixKeypad_constPin<Keypad::pin(Row - 1)>::write(HIGH);
+		return key;
+	}
+};
+
+template <class Keypad>
+struct MatrixKeypad_scanRows<Keypad, 0> {
+
+	static inline char run (const char *keyMap, char key) {
+		(void)keyMap;
+		return key;
+	}
+};
+
+/* Configures the pins 0 to Pin - 1 */
+template <class Keypad, uint8_t Pin>
+struct MatrixKeypad_setupPins {
+
+	static inline void run () {
+		MatrixKeypad_setupPins<Keypad, Pin - 1>::run();
+		if(Pin - 1 < Keypad::rows) {
+			pinMode(Keypad::pin(Pin - 1), OUTPUT);
+			digitalWrite(Keypad::pin(Pin - 1), HIGH);
+		}
+		else {
+			pinMode(Keypad::pin(Pin - 1), INPUT_PULLUP);
+		}
+	}
+};
+
+template <class Keypad>
+struct MatrixKeypad_setupPins<Keypad, 0> {
+
+	static inline void run () {
+	}
+};
+
+/**
+ * Keypad with the dimensions and the pin mappings known at compile time.
+ *
+ * @tparam Rows Number of rows. Must be greater than zero.
+ * @tparam Cols Number of columns. Must be greater than zero.
+ * @tparam Pins The "Rows" row pins followed by the "Cols" column pins, in the same order of the key mapping.
+ * @since 1.2.0
+ */
+template <uint8_t Rows, uint8_t Cols, uint8_t... Pins>
+class MatrixKeypad {
+
+	static_assert(Rows > 0 && Cols > 0, "the keypad must have at least one row and one column");
+	static_assert(sizeof...(Pins) == Rows + Cols, "the number of pins must be Rows + Cols");
+
+public:
+
+	static const uint8_t rows = Rows; /**< Number of rows */
+	static const uint8_t cols = Cols; /**< Number of columns */
+
+	/**
+	 * Returns the pin of the index "i". The row pins come first, followed by the column pins.
+	 */
+	static constexpr uint8_t pin (uint8_t i) {
+		return pins[i];
+	}
+
+	/**
+	 * Creates the keypad object. The pins are configured by begin.
+	 *
+	 * @param keymap Key mapping for the keypad. Its a bidimentional matrix with "Rows" rows and "Cols" columns. You can define a variable as "const char keymap[Rows][Cols]" and cast it as "(const char*)keymap". Dont use '\0' as a mapped key.
+	 */
+	explicit MatrixKeypad (const char *keymap) : keyMap(keymap), lastKey('\0'), buffer('\0') {
+	}
+
+	/**
+	 * Configures the row pins as outputs held high and the column pins as inputs with pullup resistors.
+	 * Must be called inside the "setup()" function.
+	 */
+	void begin () {
+		MatrixKeypad_setupPins<MatrixKeypad, Rows + Cols>::run();
+	}
+
+	/**
+	 * Scans the keypad to check if a key is currently pressed. Same as MatrixKeypad_scan.
+	 */
+	void scan () {
+
+		char key = MatrixKeypad_scanRows<MatrixKeypad, Rows>::run(keyMap, '\0');
+
+		if(lastKey != key) {	/* saves the key in the buffer only if the last key was released */
+			lastKey = key;
+			if(key != '\0') {
+				buffer = key;
+			}
+		}
+	}
+
+	/**
+	 * Checks if a keypress was detected. Same as MatrixKeypad_hasKey.
+	 *
+	 * @return 1 if a key was pressed or 0 if none was pressed.
+	 */
+	uint8_t hasKey () const {
+		return buffer != '\0' ? 1 : 0;
+	}
+
+	/**
+	 * Returns the last key pressed. Same as MatrixKeypad_getKey.
+	 *
+	 * @return The pressed key character from the key mapping or '\0' (null character) if none key was pressed.
+	 */
+	char getKey () {
+
+		char key = buffer;
+
+		buffer = '\0'; /* a key press event can be read only one time */
+		return key;
+	}
+
+	/**
+	 * Waits until a key is pressed and returns it. Same as MatrixKeypad_waitForKey.
+	 *
+	 * @return The pressed key character from the key mapping.
+	 */
+	char waitForKey () {
+
+		while(!hasKey()) {
+			scan();
+		}
+		return getKey();
+	}
+
+	/**
+	 * Waits until a key is pressed or a timeout occurs and returns it. Same as MatrixKeypad_waitForKeyTimeout.
+	 *
+	 * @param timeout Maximum time in milliseconds to wait for a event.
+	 * @return The pressed key character from the key mapping or '\0' if a timeout occurs.
+	 */
+	char waitForKeyTimeout (uint16_t timeout) {
+
+		uint32_t startTime = millis();
+
+		while(!hasKey() && !MATRIXKEYPAD_TIMED_OUT(startTime, millis(), timeout)) {
+			scan();
+		}
+		return getKey();
+	}
+
+	/**
+	 * Cleans the unread keys buffer. Same as MatrixKeypad_flush.
+	 */
+	void flush () {
+		buffer = '\0';
+	}
+
+private:
+
+	static constexpr uint8_t pins[] = {Pins...};
+
+	const char *keyMap;
+	char lastKey;
+	char buffer;
+};
+
+template <uint8_t Rows, uint8_t Cols, uint8_t... Pins>
+constexpr uint8_t MatrixKeypad<Rows, Cols, Pins...>::pins[];
+
+#endif
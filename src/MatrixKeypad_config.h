@@ -0,0 +1,559 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_config.h
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Compile time options of the library.
+ *
+ * The options are plain macros. You can change the default values in this file or define them as compiler flags
+ * (for example "-DMATRIXKEYPAD_FAST_IO=1" in the build flags of PlatformIO or in a "platform.local.txt" file).
+ * Defining them inside the sketch has no effect because the library is compiled separately.
+ *
+ */
+#ifndef MATRIXKEYPAD_CONFIG_H
+#define MATRIXKEYPAD_CONFIG_H
+
+/**
+ * Enables the direct port register backend.
+ * The row and column pins are resolved to their port register and bit mask only once, inside MatrixKeypad_create,
+ * and the scan accesses the registers directly instead of calling digitalWrite and digitalRead.
+ * Only the AVR cores are supported. The other cores fall back to the Arduino functions.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_FAST_IO
+	#define MATRIXKEYPAD_FAST_IO 0
+#endif
+
+/**
+ * Maximum number of rows of a keypad. Only used by the features that keep state for each row.
+ * Keypads with more rows are rejected by MatrixKeypad_create.
+ */
+#ifndef MATRIXKEYPAD_MAX_ROWS
+	#define MATRIXKEYPAD_MAX_ROWS 8
+#endif
+
+/**
+ * Maximum number of columns of a keypad. Only used by the features that keep state for each column. Can't be greater than 32.
+ * Keypads with more columns are rejected by MatrixKeypad_create.
+ */
+#ifndef MATRIXKEYPAD_MAX_COLS
+	#define MATRIXKEYPAD_MAX_COLS 8
+#endif
+
+/**
+ * Maximum number of ports that the columns of a keypad can be spread across to be read with one load per port.
+ * If the columns use more ports, each column pin is read individually.
+ * Only used by the direct port register backend.
+ */
+#ifndef MATRIXKEYPAD_PORT_GROUPS
+	#define MATRIXKEYPAD_PORT_GROUPS 2
+#endif
+
+/**
+ * Enables the interrupt driven idle mode (MatrixKeypad_setIdleMode).
+ * In idle mode all rows are held LOW and the column pins fire an interrupt when a key is pressed, so MatrixKeypad_scan
+ * only scans the keypad after an edge and returns immediately otherwise.
+ * Uses the external interrupts (attachInterrupt) of the pins that have one and, on AVR, the pin change interrupts of the others.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_INTERRUPTS
+	#define MATRIXKEYPAD_INTERRUPTS 0
+#endif
+
+/**
+ * Defines the pin change interrupt vectors (PCINTx_vect) on AVR. Only used by the idle mode.
+ * Set it to 0 if another library defines them (for example SoftwareSerial) and call MatrixKeypad_wakeFromISR from your own ISR.
+ */
+#ifndef MATRIXKEYPAD_PCINT_ISR
+	#define MATRIXKEYPAD_PCINT_ISR 1
+#endif
+
+/**
+ * Enables the background scanning by a hardware timer interrupt (MatrixKeypad_startTimer).
+ * Each timer tick scans one row, so the cost of a tick is small and bounded. The keys are read with MatrixKeypad_hasKey and MatrixKeypad_getKey without disabling the interrupts.
+ * Uses the Timer2 on AVR (the tone function can't be used) and the esp_timer on ESP32. On the other cores MatrixKeypad_tick can be called from your own timer interrupt.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_TIMER
+	#define MATRIXKEYPAD_TIMER 0
+#endif
+
+/**
+ * Size of the key queue. Must be 0 or a power of 2 up to 128.
+ * With 0, the keypad saves only the last key pressed and a new key overwrites an unread one.
+ * Otherwise, the keys are kept in a lock-free ring buffer, safe between a producer in an interrupt (MATRIXKEYPAD_TIMER) and the consumer in "loop()",
+ * and the keys pressed while the queue is full are dropped and counted (MatrixKeypad_getOverflowCount).
+ */
+#ifndef MATRIXKEYPAD_QUEUE_SIZE
+	#define MATRIXKEYPAD_QUEUE_SIZE 0
+#endif
+
+/**
+ * Enables the multiple keys scan.
+ * The scan keeps the state of every key as a bitmap, one word for each row and one bit for each column, and compares it with the previous frame.
+ * Each key pressed is delivered to MatrixKeypad_getKey, even if other keys are being held, and chords can be read with MatrixKeypad_isKeyPressed.
+ * The keypad can't have more than MATRIXKEYPAD_MAX_ROWS rows or MATRIXKEYPAD_MAX_COLS columns.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_MULTIKEY
+	#define MATRIXKEYPAD_MULTIKEY 0
+#endif
+
+/**
+ * Enables the idle probe and the early exit of the scan.
+ * Before each frame, all rows are driven LOW together and the columns are read once. The rows are only scanned one by one if a key is pressed,
+ * so the scan of an idle keypad costs one column read and two row writes.
+ * Without MATRIXKEYPAD_MULTIKEY, the scan also stops at the first row with a key pressed. If two keys are pressed, the one in the upper row is detected instead of the lower one.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_EARLY_EXIT
+	#define MATRIXKEYPAD_EARLY_EXIT 0
+#endif
+
+/**
+ * Enables the row settle time (MatrixKeypad_setSettleTime).
+ * After a row is strobed, the scan waits for the column lines to settle before reading them. Needed by long cables, mostly with MATRIXKEYPAD_FAST_IO.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_SETTLE
+	#define MATRIXKEYPAD_SETTLE 0
+#endif
+
+/**
+ * Default row settle time in microseconds. 0 doesn't wait. Only used by MATRIXKEYPAD_SETTLE.
+ */
+#ifndef MATRIXKEYPAD_SETTLE_TIME
+	#define MATRIXKEYPAD_SETTLE_TIME 0
+#endif
+
+/**
+ * Enables the adaptive scan rate (MatrixKeypad_poll).
+ * MatrixKeypad_poll scans the keypad each MATRIXKEYPAD_ACTIVE_INTERVAL milliseconds while a key is pressed and each MATRIXKEYPAD_IDLE_INTERVAL milliseconds otherwise,
+ * so an idle keypad costs less cpu time while a pressed one stays responsive.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_ADAPTIVE
+	#define MATRIXKEYPAD_ADAPTIVE 0
+#endif
+
+/**
+ * Default scan interval in milliseconds while a key is pressed. Only used by MATRIXKEYPAD_ADAPTIVE.
+ * Intervals shorter than the key bounce (about 10ms) need MATRIXKEYPAD_DEBOUNCE.
+ */
+#ifndef MATRIXKEYPAD_ACTIVE_INTERVAL
+	#define MATRIXKEYPAD_ACTIVE_INTERVAL 10
+#endif
+
+/**
+ * Default scan interval in milliseconds while no key is pressed. Only used by MATRIXKEYPAD_ADAPTIVE.
+ */
+#ifndef MATRIXKEYPAD_IDLE_INTERVAL
+	#define MATRIXKEYPAD_IDLE_INTERVAL 50
+#endif
+
+/**
+ * Enables the keypad groups (MatrixKeypad_scanGroup).
+ * A group is a set of keypads that share the row pins and have their own column pins. The group scan strobes each row once
+ * and reads the columns of all keypads, instead of strobing the rows once per keypad.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_GROUP
+	#define MATRIXKEYPAD_GROUP 0
+#endif
+
+/**
+ * Reads the key mappings and the pin mappings from the flash memory on AVR. All keypads must declare them with PROGMEM (or const __flash),
+ * so they don't use SRAM. The other cores read the constant tables directly from the flash, so the option has no effect on them.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_PROGMEM
+	#define MATRIXKEYPAD_PROGMEM 0
+#endif
+
+/**
+ * Enables the compact keypad objects. A keypad keeps a pointer to a constant layout (MatrixKeypad_layout_t) with its pin mappings, key mapping and dimensions,
+ * instead of one pointer for each mapping, so the keypads wired the same way share one layout in the flash and each keypad only holds its state.
+ * The keypads are initialized by MatrixKeypad_initLayout or MATRIXKEYPAD_COMPACT_INITIALIZER. MatrixKeypad_create, MatrixKeypad_init, MatrixKeypad_initTransport,
+ * MatrixKeypad_setKeymap and MATRIXKEYPAD_INITIALIZER aren't available. MatrixKeypad_step is only available with MATRIXKEYPAD_TIMER or MATRIXKEYPAD_GROUP,
+ * that keep the frame in progress in each keypad.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_COMPACT
+	#define MATRIXKEYPAD_COMPACT 0
+#endif
+
+/**
+ * Enables the key index (MatrixKeypad_getKeyIndex) and the lookup tables (MatrixKeypad_setLookup). The scan saves the index of each key (row * coln + col)
+ * instead of its character and the key mapping is only read by MatrixKeypad_getKey, so the keys can be mapped to 8, 16 or 32 bit values like HID usage codes.
+ * The keypad can't have more than 255 keys.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_INDEX
+	#define MATRIXKEYPAD_INDEX 0
+#endif
+
+/**
+ * Enables the scan instrumentation (MatrixKeypad_getStats). Counts the frames, their worst and average duration, the longest gap between two frames,
+ * the keys overwritten or dropped before being read and a histogram of the time from the detection of a key press to its read.
+ * Disabled, it adds no code and no fields.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_STATS
+	#define MATRIXKEYPAD_STATS 0
+#endif
+
+/**
+ * Number of buckets of the latency histogram. The bucket 0 counts the reads in less than 1ms and the bucket B the reads from 2^(B-1) to 2^B - 1 ms.
+ * The last bucket also counts the longer reads.
+ */
+#ifndef MATRIXKEYPAD_STATS_BUCKETS
+	#define MATRIXKEYPAD_STATS_BUCKETS 8
+#endif
+
+/**
+ * Enables the keypads that are accessed through a transport (MatrixKeypad_initTransport) instead of the row and column pins,
+ * like shift registers or I2C port expanders. The backends are in MatrixKeypad_transport.h.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_TRANSPORT
+	#define MATRIXKEYPAD_TRANSPORT 0
+#endif
+
+/**
+ * Enables the backends of MatrixKeypad_transport.h. Each one requires MATRIXKEYPAD_TRANSPORT and links its bus library:
+ * MATRIXKEYPAD_SHIFT for the 74HC595 and 74HC165 shift registers (SPI), MATRIXKEYPAD_MCP23017 and MATRIXKEYPAD_PCF8574 for the I2C port expanders (Wire)
+ * and MATRIXKEYPAD_CHARLIEPLEX for the charlieplexed keypads, where N pins serve N * (N - 1) keys (no library).
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_SHIFT
+	#define MATRIXKEYPAD_SHIFT 0
+#endif
+
+#ifndef MATRIXKEYPAD_MCP23017
+	#define MATRIXKEYPAD_MCP23017 0
+#endif
+
+#ifndef MATRIXKEYPAD_PCF8574
+	#define MATRIXKEYPAD_PCF8574 0
+#endif
+
+#ifndef MATRIXKEYPAD_CHARLIEPLEX
+	#define MATRIXKEYPAD_CHARLIEPLEX 0
+#endif
+
+/**
+ * Enables the hardware scan backend of MatrixKeypad_transport.h (MatrixKeypad_initHardwareScan). Requires MATRIXKEYPAD_TRANSPORT.
+ * The rows are strobed and the columns sampled by the hardware, without the CPU, and the scan only compares the last frame:
+ * on RP2040 a PIO state machine strobes the rows and a DMA channel copies the column words to a ring buffer,
+ * on STM32F4 the TIM1 triggers two DMA2 streams, one that writes the row strobes to the BSRR and one that copies the IDR of the columns.
+ * The other cores have no hardware scan and MatrixKeypad_initHardwareScan returns NULL.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_HARDWARE_SCAN
+	#define MATRIXKEYPAD_HARDWARE_SCAN 0
+#endif
+
+/**
+ * Enables the debouncing of the multiple keys scan. Requires MATRIXKEYPAD_MULTIKEY.
+ * A key is only accepted as pressed or released after it reads the same for a number of consecutive scans (MatrixKeypad_setDebounce).
+ * The counters of all keys of a row are updated at once (vertical counters), using MATRIXKEYPAD_DEBOUNCE_BITS words per row.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_DEBOUNCE
+	#define MATRIXKEYPAD_DEBOUNCE 0
+#endif
+
+/**
+ * Number of bits of the debounce counters. The maximum debounce count is 2^MATRIXKEYPAD_DEBOUNCE_BITS - 1.
+ */
+#ifndef MATRIXKEYPAD_DEBOUNCE_BITS
+	#define MATRIXKEYPAD_DEBOUNCE_BITS 3
+#endif
+
+/**
+ * Default number of consecutive scans a key must read the same to be accepted.
+ */
+#ifndef MATRIXKEYPAD_DEBOUNCE_COUNT
+	#define MATRIXKEYPAD_DEBOUNCE_COUNT 3
+#endif
+
+/**
+ * Enables the ghost key detection of the multiple keys scan. Requires MATRIXKEYPAD_MULTIKEY.
+ * On a keypad without diodes, pressing three corners of a rectangle makes the fourth one read as pressed. The scan finds the pairs of rows
+ * that share two or more pressed columns and keeps the previous state of those keys, so the ambiguous keys are neither pressed nor released (MatrixKeypad_isGhosted).
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_GHOST
+	#define MATRIXKEYPAD_GHOST 0
+#endif
+
+/**
+ * Enables the key events. Requires MATRIXKEYPAD_MULTIKEY and MATRIXKEYPAD_QUEUE_SIZE greater than zero.
+ * The queue holds events (MatrixKeypad_event_t) instead of characters: the key index, the type (press, release, hold or repeat) and the time of the scan that detected it.
+ * The events are read with MatrixKeypad_getEvent. MatrixKeypad_getKey still returns the key presses.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_EVENTS
+	#define MATRIXKEYPAD_EVENTS 0
+#endif
+
+/**
+ * Enables the auto-repeat and long press engine. Requires MATRIXKEYPAD_EVENTS.
+ * Each frame checks the last key pressed against one timer: after the repeat delay it adds a repeat event to the queue at each repeat interval
+ * and after the long press time it adds one hold event. MatrixKeypad_getKey also returns the repeats (MatrixKeypad_setRepeat).
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_REPEAT
+	#define MATRIXKEYPAD_REPEAT 0
+#endif
+
+/**
+ * Default time in milliseconds a key must be held before it repeats. 0 disables the repeat. Only used by MATRIXKEYPAD_REPEAT.
+ */
+#ifndef MATRIXKEYPAD_REPEAT_DELAY
+	#define MATRIXKEYPAD_REPEAT_DELAY 500
+#endif
+
+/**
+ * Default time in milliseconds between two repeats of a held key. 0 disables the repeat. Only used by MATRIXKEYPAD_REPEAT.
+ */
+#ifndef MATRIXKEYPAD_REPEAT_INTERVAL
+	#define MATRIXKEYPAD_REPEAT_INTERVAL 100
+#endif
+
+/**
+ * Default time in milliseconds a key must be held to be a long press (hold event). 0 disables the hold event. Only used by MATRIXKEYPAD_REPEAT.
+ */
+#ifndef MATRIXKEYPAD_HOLD_TIME
+	#define MATRIXKEYPAD_HOLD_TIME 1000
+#endif
+
+/**
+ * Enables the press and release callbacks (MatrixKeypad_setCallbacks).
+ * The scan calls them only for the keys that changed in the frame, so the sketch doesn't need to check MatrixKeypad_hasKey in each iteration of "loop()".
+ * They are called by the function that scans the keypad, so with MATRIXKEYPAD_TIMER they run inside the timer interrupt, unless MATRIXKEYPAD_DEFERRED_CALLBACKS is enabled.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_CALLBACKS
+	#define MATRIXKEYPAD_CALLBACKS 0
+#endif
+
+/**
+ * Defers the callbacks to MatrixKeypad_dispatch. Requires MATRIXKEYPAD_CALLBACKS.
+ * The scan only marks the keys pressed since the last dispatch, so it stays short inside an interrupt, and MatrixKeypad_dispatch, called from "loop()",
+ * runs the callbacks. A key pressed and released between two dispatches still gets both callbacks, but the repeated presses of a key in this time are merged.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_DEFERRED_CALLBACKS
+	#define MATRIXKEYPAD_DEFERRED_CALLBACKS 0
+#endif
+
+/**
+ * Enables the low power wait of MatrixKeypad_waitForKey and MatrixKeypad_waitForKeyTimeout.
+ * Instead of scanning the keypad in a busy loop, the wait functions sleep between two scans:
+ * the AVR cores enter the idle sleep mode until the next interrupt (the millis timer, the timer of MATRIXKEYPAD_TIMER or the column edge of the idle mode),
+ * the ESP32 blocks the task for MATRIXKEYPAD_WAIT_INTERVAL milliseconds (or until the column edge of the idle mode) and the other cores call "yield()".
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_WAIT_SLEEP
+	#define MATRIXKEYPAD_WAIT_SLEEP 0
+#endif
+
+/**
+ * Time in milliseconds that a task waits between two scans of the wait functions. Only used by the low power wait on ESP32.
+ */
+#ifndef MATRIXKEYPAD_WAIT_INTERVAL
+	#define MATRIXKEYPAD_WAIT_INTERVAL 5
+#endif
+
+/**
+ * Enables the deep sleep of MatrixKeypad_waitForKey. Requires MATRIXKEYPAD_WAIT_SLEEP and MATRIXKEYPAD_INTERRUPTS.
+ * The wait puts the keypad in the idle mode, so the rows are held LOW and the columns wake the core, and while all keys are released it enters the deepest
+ * sleep that a column can wake: the power-down mode on AVR (with the pin change interrupts of the columns), the light sleep with the GPIO wakeup on ESP32
+ * and the standby mode on SAMD21 (with the EIC clocked by the ultra low power oscillator). The other cores use the sleep of MATRIXKEYPAD_WAIT_SLEEP.
+ * On wake, the keypad is scanned (and debounced) as in the wait of MATRIXKEYPAD_WAIT_SLEEP until the key is read.
+ * The whole core sleeps, so the timers, millis() and the other tasks stop until a key is pressed. The timeout waits keep the sleep of MATRIXKEYPAD_WAIT_SLEEP.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_DEEP_SLEEP
+	#define MATRIXKEYPAD_DEEP_SLEEP 0
+#endif
+
+/**
+ * Enables the FreeRTOS scan task on ESP32 (MatrixKeypad_startTask).
+ * A task pinned to a core scans the keypad periodically and posts each key (or event, with MATRIXKEYPAD_EVENTS) to the FreeRTOS queues
+ * registered by MatrixKeypad_subscribe, so each consumer task blocks on its own queue instead of sharing the keypad.
+ * 1 to enable or 0 to disable.
+ */
+#ifndef MATRIXKEYPAD_RTOS
+	#define MATRIXKEYPAD_RTOS 0
+#endif
+
+/**
+ * Maximum number of subscriber queues of a keypad. Only used by the scan task.
+ */
+#ifndef MATRIXKEYPAD_RTOS_SUBSCRIBERS
+	#define MATRIXKEYPAD_RTOS_SUBSCRIBERS 2
+#endif
+
+/**
+ * Stack size of the scan task, in bytes. Only used by the scan task.
+ */
+#ifndef MATRIXKEYPAD_RTOS_STACK
+	#define MATRIXKEYPAD_RTOS_STACK 2048
+#endif
+
+/* Derived options. Don't change them. */
+
+#if MATRIXKEYPAD_FAST_IO && defined(__AVR__)
+	#define MATRIXKEYPAD_USE_PORTS 1
+#else
+	#define MATRIXKEYPAD_USE_PORTS 0
+#endif
+
+#if MATRIXKEYPAD_PROGMEM && defined(__AVR__)
+	#define MATRIXKEYPAD_USE_PGM 1
+#else
+	#define MATRIXKEYPAD_USE_PGM 0
+#endif
+
+#if MATRIXKEYPAD_TIMER && defined(ESP32)
+	#define MATRIXKEYPAD_USE_ESP_TIMER 1
+#else
+	#define MATRIXKEYPAD_USE_ESP_TIMER 0
+#endif
+
+#if MATRIXKEYPAD_HARDWARE_SCAN && defined(ARDUINO_ARCH_RP2040)
+	#define MATRIXKEYPAD_USE_PIO 1
+#else
+	#define MATRIXKEYPAD_USE_PIO 0
+#endif
+
+#if MATRIXKEYPAD_HARDWARE_SCAN && defined(STM32F4xx)
+	#define MATRIXKEYPAD_USE_STM32_DMA 1
+#else
+	#define MATRIXKEYPAD_USE_STM32_DMA 0
+#endif
+
+#if MATRIXKEYPAD_WAIT_SLEEP && defined(ESP32)
+	#define MATRIXKEYPAD_USE_RTOS_WAIT 1
+#else
+	#define MATRIXKEYPAD_USE_RTOS_WAIT 0
+#endif
+
+#if MATRIXKEYPAD_RTOS && defined(ESP32)
+	#define MATRIXKEYPAD_USE_RTOS 1
+#else
+	#define MATRIXKEYPAD_USE_RTOS 0
+#endif
+
+#if (MATRIXKEYPAD_USE_RTOS_WAIT || MATRIXKEYPAD_USE_RTOS) && MATRIXKEYPAD_INTERRUPTS
+	#define MATRIXKEYPAD_USE_NOTIFY 1
+#else
+	#define MATRIXKEYPAD_USE_NOTIFY 0
+#endif
+
+#if MATRIXKEYPAD_DEBOUNCE && !MATRIXKEYPAD_MULTIKEY
+	#error "MATRIXKEYPAD_DEBOUNCE requires MATRIXKEYPAD_MULTIKEY"
+#endif
+
+#if MATRIXKEYPAD_DEBOUNCE && (MATRIXKEYPAD_DEBOUNCE_COUNT < 1 || MATRIXKEYPAD_DEBOUNCE_COUNT >= (1 << MATRIXKEYPAD_DEBOUNCE_BITS))
+	#error "MATRIXKEYPAD_DEBOUNCE_COUNT must be between 1 and 2^MATRIXKEYPAD_DEBOUNCE_BITS - 1"
+#endif
+
+#if MATRIXKEYPAD_REPEAT && !MATRIXKEYPAD_EVENTS
+	#error "MATRIXKEYPAD_REPEAT requires MATRIXKEYPAD_EVENTS"
+#endif
+
+#if MATRIXKEYPAD_REPEAT && (MATRIXKEYPAD_REPEAT_DELAY > 32767 || MATRIXKEYPAD_REPEAT_INTERVAL > 32767 || MATRIXKEYPAD_HOLD_TIME > 32767)
+	#error "MATRIXKEYPAD_REPEAT_DELAY, MATRIXKEYPAD_REPEAT_INTERVAL and MATRIXKEYPAD_HOLD_TIME can't be greater than 32767"
+#endif
+
+#if MATRIXKEYPAD_DEFERRED_CALLBACKS && !MATRIXKEYPAD_CALLBACKS
+	#error "MATRIXKEYPAD_DEFERRED_CALLBACKS requires MATRIXKEYPAD_CALLBACKS"
+#endif
+
+#if MATRIXKEYPAD_DEEP_SLEEP && (!MATRIXKEYPAD_WAIT_SLEEP || !MATRIXKEYPAD_INTERRUPTS)
+	#error "MATRIXKEYPAD_DEEP_SLEEP requires MATRIXKEYPAD_WAIT_SLEEP and MATRIXKEYPAD_INTERRUPTS"
+#endif
+
+#if MATRIXKEYPAD_GHOST && !MATRIXKEYPAD_MULTIKEY
+	#error "MATRIXKEYPAD_GHOST requires MATRIXKEYPAD_MULTIKEY"
+#endif
+
+#if MATRIXKEYPAD_EVENTS && (!MATRIXKEYPAD_MULTIKEY || MATRIXKEYPAD_QUEUE_SIZE == 0)
+	#error "MATRIXKEYPAD_EVENTS requires MATRIXKEYPAD_MULTIKEY and MATRIXKEYPAD_QUEUE_SIZE greater than zero"
+#endif
+
+#if MATRIXKEYPAD_EVENTS && MATRIXKEYPAD_MAX_ROWS * MATRIXKEYPAD_MAX_COLS > 256
+	#error "MATRIXKEYPAD_EVENTS requires MATRIXKEYPAD_MAX_ROWS * MATRIXKEYPAD_MAX_COLS up to 256, the key index is 8 bits"
+#endif
+
+#if (MATRIXKEYPAD_SHIFT || MATRIXKEYPAD_MCP23017 || MATRIXKEYPAD_PCF8574 || MATRIXKEYPAD_CHARLIEPLEX || MATRIXKEYPAD_HARDWARE_SCAN) && !MATRIXKEYPAD_TRANSPORT
+	#error "the transport backends require MATRIXKEYPAD_TRANSPORT"
+#endif
+
+#if MATRIXKEYPAD_MAX_COLS > 32
+	#error "MATRIXKEYPAD_MAX_COLS can't be greater than 32"
+#endif
+
+#if (MATRIXKEYPAD_QUEUE_SIZE & (MATRIXKEYPAD_QUEUE_SIZE - 1)) != 0 || MATRIXKEYPAD_QUEUE_SIZE > 128
+	#error "MATRIXKEYPAD_QUEUE_SIZE must be 0 or a power of 2 up to 128"
+#endif
+
+#if MATRIXKEYPAD_QUEUE_SIZE > 0
+	#define MATRIXKEYPAD_USE_QUEUE 1
+#else
+	#define MATRIXKEYPAD_USE_QUEUE 0
+#endif
+
+#if MATRIXKEYPAD_TIMER && !MATRIXKEYPAD_USE_QUEUE
+	#define MATRIXKEYPAD_USE_SEQ 1
+#else
+	#define MATRIXKEYPAD_USE_SEQ 0
+#endif
+
+#if !MATRIXKEYPAD_COMPACT || MATRIXKEYPAD_TIMER || MATRIXKEYPAD_GROUP
+	#define MATRIXKEYPAD_USE_STEP 1
+#else
+	#define MATRIXKEYPAD_USE_STEP 0
+#endif
+
+#if MATRIXKEYPAD_MULTIKEY || MATRIXKEYPAD_USE_STEP
+	#define MATRIXKEYPAD_USE_SHARED 1
+#else
+	#define MATRIXKEYPAD_USE_SHARED 0
+#endif
+
+#if MATRIXKEYPAD_EARLY_EXIT || MATRIXKEYPAD_TRANSPORT
+	#define MATRIXKEYPAD_USE_PROBE 1
+#else
+	#define MATRIXKEYPAD_USE_PROBE 0
+#endif
+
+#if MATRIXKEYPAD_INTERRUPTS && MATRIXKEYPAD_PCINT_ISR && defined(__AVR__)
+	#define MATRIXKEYPAD_USE_PCINT 1
+#else
+	#define MATRIXKEYPAD_USE_PCINT 0
+#endif
+
+#endif
@@ -0,0 +1,750 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_transport.cpp
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Shift register, I2C expander, charlieplexed and hardware scan backends of MatrixKeypad_transport.h. Is C++ because the SPI and Wire libraries are C++ objects.
+ *
+ */
+#include "MatrixKeypad_transport.h"
+#include "Arduino.h"
+#include <stddef.h>
+
+#if MATRIXKEYPAD_SHIFT
+#include <SPI.h>
+#endif
+#if MATRIXKEYPAD_MCP23017 || MATRIXKEYPAD_PCF8574
+#include <Wire.h>
+#endif
+#if MATRIXKEYPAD_USE_PIO
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include <string.h>
+#endif
+
+#if MATRIXKEYPAD_SHIFT
+
+static const SPISettings MatrixKeypad_shiftSettings(4000000, MSBFIRST, SPI_MODE0);
+
+/* Shifts the row levels out and latches them. The bit "R" of "rows" is the level of the row "R" */
+static void MatrixKeypad_shiftRows (MatrixKeypad_shift_t *shift, uint32_t rows){
+
+	uint8_t i;
+
+	digitalWrite(shift->latchPin, LOW);
+	SPI.beginTransaction(MatrixKeypad_shiftSettings);
+	for(i = (shift->rown + 7) / 8; i > 0; i--){ /* the last byte goes to the farthest register */
+		SPI.transfer((uint8_t)(rows >> (8 * (i - 1))));
+	}
+	SPI.endTransaction();
+	digitalWrite(shift->latchPin, HIGH); /* the outputs change on the rising edge */
+}
+
+static void MatrixKeypad_shiftBegin (void *context){
+
+	MatrixKeypad_shift_t *shift = (MatrixKeypad_shift_t *)context;
+
+	pinMode(shift->latchPin, OUTPUT);
+	pinMode(shift->loadPin, OUTPUT);
+	digitalWrite(shift->loadPin, HIGH);
+	SPI.begin();
+	MatrixKeypad_shiftRows(shift, 0); /* parks the rows LOW */
+}
+
+static void MatrixKeypad_shiftSelectRow (void *context, uint8_t row){
+
+	MatrixKeypad_shiftRows((MatrixKeypad_shift_t *)context, ~((uint32_t)1 << row));
+}
+
+static void MatrixKeypad_shiftReleaseRows (void *context){
+
+	MatrixKeypad_shiftRows((MatrixKeypad_shift_t *)context, 0);
+}
+
+static MatrixKeypad_cols_t MatrixKeypad_shiftReadCols (void *context){
+
+	MatrixKeypad_shift_t *shift = (MatrixKeypad_shift_t *)context;
+	uint32_t cols = 0;
+	uint8_t i;
+
+	digitalWrite(shift->loadPin, LOW); /* samples the columns */
+	digitalWrite(shift->loadPin, HIGH);
+	SPI.beginTransaction(MatrixKeypad_shiftSettings);
+	for(i = 0; i < (shift->coln + 7) / 8; i++){ /* D7 comes first, so the bit "C" of each byte is the input D(C) */
+		cols |= (uint32_t)(uint8_t)~SPI.transfer(0) << (8 * i); /* a pressed key reads LOW */
+	}
+	SPI.endTransaction();
+
+	if(shift->coln < 32) {
+		cols &= ((uint32_t)1 << shift->coln) - 1;
+	}
+
+	return (MatrixKeypad_cols_t)cols;
+}
+
+static uint8_t MatrixKeypad_shiftProbe (void *context){
+
+	return MatrixKeypad_shiftReadCols(context) != 0; /* the rows are parked LOW */
+}
+
+MatrixKeypad_transport_t *MatrixKeypad_initShift (MatrixKeypad_transport_t *transport, MatrixKeypad_shift_t *shift, uint8_t latchPin, uint8_t loadPin, uint8_t rown, uint8_t coln){
+
+	if(transport == NULL || shift == NULL || rown == 0 || rown > 32 || coln == 0 || coln > 32) {
+		return NULL;
+	}
+
+	shift->latchPin = latchPin;
+	shift->loadPin = loadPin;
+	shift->rown = rown;
+	shift->coln = coln;
+
+	transport->begin = MatrixKeypad_shiftBegin;
+	transport->selectRow = MatrixKeypad_shiftSelectRow;
+	transport->releaseRows = MatrixKeypad_shiftReleaseRows;
+	transport->readCols = MatrixKeypad_shiftReadCols;
+	transport->probe = MatrixKeypad_shiftProbe;
+	transport->readFrame = NULL;
+	transport->context = shift;
+	transport->rown = rown;
+	transport->coln = coln;
+
+	return transport;
+}
+#endif
+
+#if MATRIXKEYPAD_MCP23017
+
+/* registers with IOCON.BANK = 0 (power on default) */
+#define MATRIXKEYPAD_MCP_IODIRA 0x00
+#define MATRIXKEYPAD_MCP_IODIRB 0x01
+#define MATRIXKEYPAD_MCP_GPINTENB 0x05
+#define MATRIXKEYPAD_MCP_DEFVALB 0x07
+#define MATRIXKEYPAD_MCP_INTCONB 0x09
+#define MATRIXKEYPAD_MCP_IOCON 0x0A
+#define MATRIXKEYPAD_MCP_GPPUB 0x0D
+#define MATRIXKEYPAD_MCP_GPIOB 0x13
+#define MATRIXKEYPAD_MCP_OLATA 0x14
+
+static void MatrixKeypad_mcpWrite (MatrixKeypad_mcp23017_t *mcp, uint8_t reg, uint8_t value){
+
+	Wire.beginTransmission(mcp->address);
+	Wire.write(reg);
+	Wire.write(value);
+	Wire.endTransmission();
+}
+
+static void MatrixKeypad_mcpBegin (void *context){
+
+	MatrixKeypad_mcp23017_t *mcp = (MatrixKeypad_mcp23017_t *)context;
+
+	Wire.begin();
+	/* The rows are open drain: the output latches are LOW and a row is driven by making it an output.
+	 * The other rows are inputs, so two keys pressed on the same column don't short a HIGH row to a LOW one.
+	 */
+	MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_OLATA, 0x00);
+	MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_IODIRA, (uint8_t)~mcp->rowMask); /* parks the rows LOW */
+	MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_IODIRB, 0xFF);
+	MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_GPPUB, mcp->colMask);
+
+	if(mcp->intPin != 0xFF) {
+		/* INTA and INTB are mirrored and go LOW while a column differs from DEFVAL (HIGH) */
+		MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_IOCON, 0x40);
+		MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_DEFVALB, mcp->colMask);
+		MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_INTCONB, mcp->colMask);
+		MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_GPINTENB, mcp->colMask);
+		pinMode(mcp->intPin, INPUT_PULLUP);
+	}
+}
+
+static void MatrixKeypad_mcpSelectRow (void *context, uint8_t row){
+
+	MatrixKeypad_mcpWrite((MatrixKeypad_mcp23017_t *)context, MATRIXKEYPAD_MCP_IODIRA, (uint8_t)~(1 << row));
+}
+
+static void MatrixKeypad_mcpReleaseRows (void *context){
+
+	MatrixKeypad_mcp23017_t *mcp = (MatrixKeypad_mcp23017_t *)context;
+
+	MatrixKeypad_mcpWrite(mcp, MATRIXKEYPAD_MCP_IODIRA, (uint8_t)~mcp->rowMask);
+}
+
+static MatrixKeypad_cols_t MatrixKeypad_mcpReadCols (void *context){
+
+	MatrixKeypad_mcp23017_t *mcp = (MatrixKeypad_mcp23017_t *)context;
+	uint8_t value = 0xFF;
+
+	Wire.beginTransmission(mcp->address);
+	Wire.write(MATRIXKEYPAD_MCP_GPIOB); /* reading GPIOB also clears the interrupt */
+	Wire.endTransmission(false); /* repeated start */
+	if(Wire.requestFrom(mcp->address, (uint8_t)1) == 1) {
+		value = Wire.read();
+	}
+
+	return (MatrixKeypad_cols_t)((uint8_t)~value & mcp->colMask); /* a pressed key reads LOW */
+}
+
+static uint8_t MatrixKeypad_mcpProbe (void *context){
+
+	MatrixKeypad_mcp23017_t *mcp = (MatrixKeypad_mcp23017_t *)context;
+
+	if(mcp->intPin != 0xFF) {
+		return digitalRead(mcp->intPin) == LOW;
+	}
+	return MatrixKeypad_mcpReadCols(context) != 0; /* the rows are parked LOW */
+}
+
+MatrixKeypad_transport_t *MatrixKeypad_initMCP23017 (MatrixKeypad_transport_t *transport, MatrixKeypad_mcp23017_t *mcp, uint8_t address, uint8_t intPin, uint8_t rown, uint8_t coln){
+
+	if(transport == NULL || mcp == NULL || rown == 0 || rown > 8 || coln == 0 || coln > 8) {
+		return NULL;
+	}
+
+	mcp->address = address;
+	mcp->intPin = intPin;
+	mcp->rowMask = (uint8_t)((1 << rown) - 1);
+	mcp->colMask = (uint8_t)((1 << coln) - 1);
+
+	transport->begin = MatrixKeypad_mcpBegin;
+	transport->selectRow = MatrixKeypad_mcpSelectRow;
+	transport->releaseRows = MatrixKeypad_mcpReleaseRows;
+	transport->readCols = MatrixKeypad_mcpReadCols;
+	transport->probe = MatrixKeypad_mcpProbe;
+	transport->readFrame = NULL;
+	transport->context = mcp;
+	transport->rown = rown;
+	transport->coln = coln;
+
+	return transport;
+}
+#endif
+
+#if MATRIXKEYPAD_PCF8574
+
+/* The pins are quasi bidirectional: writing 0 drives the pin LOW and writing 1 leaves it HIGH with a weak pullup, so it can be read */
+static void MatrixKeypad_pcfWrite (MatrixKeypad_pcf8574_t *pcf, uint8_t value){
+
+	Wire.beginTransmission(pcf->address);
+	Wire.write(value);
+	Wire.endTransmission();
+}
+
+static void MatrixKeypad_pcfReleaseRows (void *context){
+
+	MatrixKeypad_pcf8574_t *pcf = (MatrixKeypad_pcf8574_t *)context;
+
+	MatrixKeypad_pcfWrite(pcf, (uint8_t)~pcf->rowMask); /* parks the rows LOW */
+}
+
+static void MatrixKeypad_pcfBegin (void *context){
+
+	Wire.begin();
+	MatrixKeypad_pcfReleaseRows(context);
+}
+
+static void MatrixKeypad_pcfSelectRow (void *context, uint8_t row){
+
+	MatrixKeypad_pcfWrite((MatrixKeypad_pcf8574_t *)context, (uint8_t)~(1 << row));
+}
+
+static MatrixKeypad_cols_t MatrixKeypad_pcfReadCols (void *context){
+
+	MatrixKeypad_pcf8574_t *pcf = (MatrixKeypad_pcf8574_t *)context;
+	uint8_t value = 0xFF;
+
+	if(Wire.requestFrom(pcf->address, (uint8_t)1) == 1) {
+		value = Wire.read();
+	}
+
+	return (MatrixKeypad_cols_t)(((uint8_t)~value >> pcf->rown) & pcf->colMask); /* a pressed key reads LOW */
+}
+
+static uint8_t MatrixKeypad_pcfProbe (void *context){
+
+	return MatrixKeypad_pcfReadCols(context) != 0; /* the rows are parked LOW */
+}
+
+MatrixKeypad_transport_t *MatrixKeypad_initPCF8574 (MatrixKeypad_transport_t *transport, MatrixKeypad_pcf8574_t *pcf, uint8_t address, uint8_t rown, uint8_t coln){
+
+	if(transport == NULL || pcf == NULL || rown == 0 || coln == 0 || rown + coln > 8) {
+		return NULL;
+	}
+
+	pcf->address = address;
+	pcf->rown = rown;
+	pcf->rowMask = (uint8_t)((1 << rown) - 1);
+	pcf->colMask = (uint8_t)((1 << coln) - 1);
+
+	transport->begin = MatrixKeypad_pcfBegin;
+	transport->selectRow = MatrixKeypad_pcfSelectRow;
+	transport->releaseRows = MatrixKeypad_pcfReleaseRows;
+	transport->readCols = MatrixKeypad_pcfReadCols;
+	transport->probe = MatrixKeypad_pcfProbe;
+	transport->readFrame = NULL;
+	transport->context = pcf;
+	transport->rown = rown;
+	transport->coln = coln;
+
+	return transport;
+}
+#endif
+
+#if MATRIXKEYPAD_CHARLIEPLEX
+
+/* Returns a pin to the column state: input with the pullup */
+static void MatrixKeypad_charlieRelease (MatrixKeypad_charlieplex_t *cp){
+
+	if(cp->strobe != 0xFF) {
+		pinMode(cp->pins[cp->strobe], INPUT_PULLUP);
+		cp->strobe = 0xFF;
+	}
+}
+
+static void MatrixKeypad_charlieBegin (void *context){
+
+	MatrixKeypad_charlieplex_t *cp = (MatrixKeypad_charlieplex_t *)context;
+	uint8_t i;
+
+	for(i = 0; i < cp->pinn; i++){
+		pinMode(cp->pins[i], INPUT_PULLUP);
+	}
+	cp->strobe = 0xFF;
+}
+
+static void MatrixKeypad_charlieSelectRow (void *context, uint8_t row){
+
+	MatrixKeypad_charlieplex_t *cp = (MatrixKeypad_charlieplex_t *)context;
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t oldSREG;
+
+	if(cp->modeReg != NULL) {
+		/* The pullups of all pins but the strobed one are set first, then the strobed pin becomes the only output.
+		 * In between, the old strobe drives HIGH, which no key conducts, and the new one floats for a cycle
+		 */
+		oldSREG = SREG; /* the read-modify-writes must not be interrupted by an ISR that writes the same port */
+		cli();
+		*cp->outReg = (*cp->outReg | cp->mask) & (uint8_t)~cp->bits[row];
+		*cp->modeReg = (*cp->modeReg & (uint8_t)~cp->mask) | cp->bits[row];
+		SREG = oldSREG;
+		cp->strobe = row;
+		return;
+	}
+#endif
+	MatrixKeypad_charlieRelease(cp);
+	digitalWrite(cp->pins[row], LOW); /* disables the pullup before the pin is an output, so it never drives HIGH */
+	pinMode(cp->pins[row], OUTPUT);
+	cp->strobe = row;
+}
+
+static void MatrixKeypad_charlieReleaseRows (void *context){
+
+	MatrixKeypad_charlieplex_t *cp = (MatrixKeypad_charlieplex_t *)context;
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t oldSREG;
+
+	if(cp->modeReg != NULL) {
+		oldSREG = SREG;
+		cli();
+		*cp->modeReg &= (uint8_t)~cp->mask;
+		*cp->outReg |= cp->mask;
+		SREG = oldSREG;
+		cp->strobe = 0xFF;
+		return;
+	}
+#endif
+	MatrixKeypad_charlieRelease(cp);
+}
+
+static MatrixKeypad_cols_t MatrixKeypad_charlieReadCols (void *context){
+
+	MatrixKeypad_charlieplex_t *cp = (MatrixKeypad_charlieplex_t *)context;
+	MatrixKeypad_cols_t cols = 0;
+	uint8_t i;
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t value;
+
+	if(cp->modeReg != NULL) {
+		value = (uint8_t)~*cp->inReg & cp->mask; /* all pins in a single read. A pressed key reads LOW */
+		for(i = 0; value != 0; i++){
+			if(value & cp->bits[i]) {
+				cols |= (MatrixKeypad_cols_t)1 << i;
+				value &= (uint8_t)~cp->bits[i];
+			}
+		}
+		return cols & ~((MatrixKeypad_cols_t)1 << cp->strobe); /* the strobed pin reads its own LOW */
+	}
+#endif
+
+	for(i = 0; i < cp->pinn; i++){
+		if(i != cp->strobe && digitalRead(cp->pins[i]) == LOW) {
+			cols |= (MatrixKeypad_cols_t)1 << i;
+		}
+	}
+
+	return cols;
+}
+
+MatrixKeypad_transport_t *MatrixKeypad_initCharlieplex (MatrixKeypad_transport_t *transport, MatrixKeypad_charlieplex_t *charlieplex, const uint8_t *pins, uint8_t pinn){
+
+#if MATRIXKEYPAD_USE_PORTS
+	uint8_t i, port;
+#endif
+
+	if(transport == NULL || charlieplex == NULL || pins == NULL || pinn < 2 || pinn > MATRIXKEYPAD_MAX_COLS) {
+		return NULL;
+	}
+
+	charlieplex->pins = pins;
+	charlieplex->pinn = pinn;
+	charlieplex->strobe = 0xFF;
+#if MATRIXKEYPAD_USE_PORTS
+	charlieplex->modeReg = NULL; /* uses pinMode, digitalWrite and digitalRead unless all pins are on one port */
+	charlieplex->mask = 0;
+	port = digitalPinToPort(pins[0]);
+	if(pinn <= 8) {
+		for(i = 0; i < pinn && digitalPinToPort(pins[i]) == port; i++){
+			charlieplex->bits[i] = digitalPinToBitMask(pins[i]);
+			charlieplex->mask |= charlieplex->bits[i];
+		}
+		if(i == pinn) {
+			charlieplex->modeReg = portModeRegister(port);
+			charlieplex->outReg = portOutputRegister(port);
+			charlieplex->inReg = portInputRegister(port);
+		}
+	}
+#endif
+
+	transport->begin = MatrixKeypad_charlieBegin;
+	transport->selectRow = MatrixKeypad_charlieSelectRow;
+	transport->releaseRows = MatrixKeypad_charlieReleaseRows;
+	transport->readCols = MatrixKeypad_charlieReadCols;
+	transport->probe = NULL; /* every pin is also a row, so the keys can't be checked all at once */
+	transport->readFrame = NULL;
+	transport->context = charlieplex;
+	transport->rown = pinn;
+	transport->coln = pinn;
+
+	return transport;
+}
+#endif
+
+#if MATRIXKEYPAD_HARDWARE_SCAN
+
+#if MATRIXKEYPAD_USE_PIO
+
+#define MATRIXKEYPAD_PIO_LENGTH 10 /* instructions of the program */
+#define MATRIXKEYPAD_PIO_ROW_CYCLES 70 /* cycles of the program for each row: 8 instructions and two delays of 31 cycles */
+#define MATRIXKEYPAD_PIO_COUNT 0x80000000UL /* transfers of the DMA before it is restarted. A multiple of the ring, so the restart keeps the row order */
+
+/* Program of the state machine. The rows are the OUT pins, whose outputs are LOW, and a row is strobed by making it the only output.
+ * The columns are the IN pins. Each row pushes one GPIO word, in the order of the rows, and the push blocks so no word is lost.
+ * The word 0 is completed with the number of rows of the frame
+ */
+static const uint16_t MatrixKeypad_pioProgram[MATRIXKEYPAD_PIO_LENGTH] = {
+	0xE020, /* 0: set x, ring - 1 (wrap target) */
+	0xE041, /* 1: set y, 1 ; pattern of the row 0 */
+	0xA0E2, /* 2: mov osr, y */
+	0x7F80, /* 3: out pindirs, 32 [31] ; strobes the row and waits for the lines to settle */
+	0x4000, /* 4: in pins, 32 ; samples the columns */
+	0x8020, /* 5: push block */
+	0xA0C2, /* 6: mov isr, y */
+	0x4061, /* 7: in null, 1 ; moves the pattern to the next row */
+	0xA046, /* 8: mov y, isr */
+	0x1F42  /* 9: jmp x--, 2 [31] (wrap) */
+};
+
+static void MatrixKeypad_hardwareBegin (void *context){
+
+	MatrixKeypad_hardware_t *hw = (MatrixKeypad_hardware_t *)context;
+	PIO pio = (PIO)hw->pio;
+	pio_sm_config config;
+	dma_channel_config dma;
+	uint32_t rowMask = (((uint32_t)1 << hw->rown) - 1) << hw->rowPins[0];
+	float div;
+	uint8_t i, ringBits = 2;
+
+	pio_sm_set_enabled(pio, hw->sm, false); /* stops a previous scan */
+	dma_channel_abort(hw->dma);
+
+	for(i = 0; i < hw->rown; i++){
+		pio_gpio_init(pio, hw->rowPins[i]);
+		gpio_pull_up(hw->rowPins[i]);
+	}
+	for(i = 0; i < hw->coln; i++){
+		pinMode(hw->colPins[i], INPUT_PULLUP);
+	}
+	for(i = 0; i < hw->ring; i++){
+		hw->frame[i] = 0xFFFFFFFF; /* no key until the first frame */
+	}
+	while(((uint8_t)1 << (ringBits - 2)) < hw->ring){
+		ringBits++;
+	}
+
+	config = pio_get_default_sm_config();
+	sm_config_set_wrap(&config, hw->offset, hw->offset + MATRIXKEYPAD_PIO_LENGTH - 1);
+	sm_config_set_out_pins(&config, hw->rowPins[0], hw->rown);
+	sm_config_set_in_pins(&config, hw->colPins[0]);
+	sm_config_set_out_shift(&config, true, false, 32);
+	sm_config_set_in_shift(&config, false, false, 32); /* shifts left, so "in null, 1" moves the pattern up */
+	sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_RX);
+	div = (float)clock_get_hz(clk_sys) * hw->rowTime / (MATRIXKEYPAD_PIO_ROW_CYCLES * 1000000.0f);
+	sm_config_set_clkdiv(&config, div < 1.0f ? 1.0f : (div > 65535.0f ? 65535.0f : div));
+	pio_sm_init(pio, hw->sm, hw->offset, &config);
+	pio_sm_set_pins_with_mask(pio, hw->sm, 0, rowMask); /* a strobed row drives LOW */
+	pio_sm_set_pindirs_with_mask(pio, hw->sm, 0, rowMask); /* and the others are released */
+
+	dma = dma_channel_get_default_config(hw->dma);
+	channel_config_set_transfer_data_size(&dma, DMA_SIZE_32);
+	channel_config_set_read_increment(&dma, false);
+	channel_config_set_write_increment(&dma, true);
+	channel_config_set_ring(&dma, true, ringBits); /* the write address wraps at the end of the frame */
+	channel_config_set_dreq(&dma, pio_get_dreq(pio, hw->sm, false));
+	dma_channel_configure(hw->dma, &dma, hw->frame, &pio->rxf[hw->sm], MATRIXKEYPAD_PIO_COUNT, true);
+
+	pio_sm_set_enabled(pio, hw->sm, true);
+}
+
+static void MatrixKeypad_hardwareReadFrame (void *context, MatrixKeypad_cols_t *frame){
+
+	MatrixKeypad_hardware_t *hw = (MatrixKeypad_hardware_t *)context;
+	uint32_t mask = hw->coln < 32 ? ((uint32_t)1 << hw->coln) - 1 : 0xFFFFFFFF;
+	uint8_t row;
+
+	for(row = 0; row < hw->rown; row++){
+		frame[row] = (MatrixKeypad_cols_t)(~hw->frame[row] & mask); /* the column C is the bit C of the word. A pressed key reads LOW */
+	}
+	if(!dma_channel_is_busy(hw->dma)) { /* after hours of scan, the transfer count ends */
+		dma_channel_set_trans_count(hw->dma, MATRIXKEYPAD_PIO_COUNT, true);
+	}
+}
+
+/* Claims a state machine and a DMA channel and loads the program. Returns 0 if the hardware is in use */
+static uint8_t MatrixKeypad_hardwareClaim (MatrixKeypad_hardware_t *hw){
+
+	uint16_t instructions[MATRIXKEYPAD_PIO_LENGTH];
+	pio_program_t program;
+	PIO pios[2] = {pio0, pio1};
+	int sm = -1, dma;
+	uint8_t i;
+
+	for(i = 0; i < MATRIXKEYPAD_PIO_LENGTH; i++){
+		instructions[i] = MatrixKeypad_pioProgram[i];
+	}
+	instructions[0] |= hw->ring - 1;
+	memset(&program, 0, sizeof(program)); /* the newer SDKs have more fields */
+	program.instructions = instructions;
+	program.length = MATRIXKEYPAD_PIO_LENGTH;
+	program.origin = -1;
+
+	for(i = 0; i < 2 && sm < 0; i++){
+		if(pio_can_add_program(pios[i], &program)) {
+			sm = pio_claim_unused_sm(pios[i], false);
+		}
+	}
+	if(sm < 0) {
+		return 0;
+	}
+	dma = dma_claim_unused_channel(false);
+	if(dma < 0) {
+		pio_sm_unclaim(pios[i - 1], sm);
+		return 0;
+	}
+
+	hw->pio = pios[i - 1];
+	hw->sm = (uint8_t)sm;
+	hw->dma = (uint8_t)dma;
+	hw->offset = (uint8_t)pio_add_program(pios[i - 1], &program);
+
+	return 1;
+}
+
+#elif MATRIXKEYPAD_USE_STM32_DMA
+
+static MatrixKeypad_hardware_t *MatrixKeypad_hardwareOwner = NULL; /* the TIM1 and the DMA2 streams serve a single keypad */
+
+static void MatrixKeypad_hardwareBegin (void *context){
+
+	MatrixKeypad_hardware_t *hw = (MatrixKeypad_hardware_t *)context;
+	uint32_t clock;
+	uint8_t i;
+
+	__HAL_RCC_TIM1_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+	TIM1->CR1 = 0; /* stops a previous scan */
+	TIM1->DIER = 0;
+	DMA2_Stream5->CR = 0;
+	DMA2_Stream1->CR = 0;
+	while((DMA2_Stream5->CR & DMA_SxCR_EN) || (DMA2_Stream1->CR & DMA_SxCR_EN)) { /* a stream can only be configured after it stops */
+	}
+
+	for(i = 0; i < hw->rown; i++){
+		pinMode(hw->rowPins[i], OUTPUT_OPEN_DRAIN); /* a released row is high impedance */
+	}
+	for(i = 0; i < hw->coln; i++){
+		pinMode(hw->colPins[i], INPUT_PULLUP);
+	}
+	for(i = 0; i < hw->rown; i++){
+		hw->frame[i] = 0xFFFFFFFF; /* no key until the first frame */
+	}
+	((GPIO_TypeDef *)hw->rowPort)->BSRR = hw->strobe[hw->rown - 1]; /* strobes the row 0. The DMA strobes the next rows */
+
+	/* TIM1_UP requests the stream 5 and TIM1_CH1 the stream 1, both on the channel 6 */
+	DMA2->HIFCR = DMA_HIFCR_CFEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTCIF5;
+	DMA2->LIFCR = DMA_LIFCR_CFEIF1 | DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CTEIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTCIF1;
+	DMA2_Stream5->PAR = (uint32_t)&((GPIO_TypeDef *)hw->rowPort)->BSRR;
+	DMA2_Stream5->M0AR = (uint32_t)hw->strobe;
+	DMA2_Stream5->NDTR = hw->rown;
+	DMA2_Stream5->FCR = 0; /* direct mode */
+	DMA2_Stream5->CR = DMA_SxCR_CHSEL_2 | DMA_SxCR_CHSEL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0 | DMA_SxCR_EN;
+	DMA2_Stream1->PAR = (uint32_t)&((GPIO_TypeDef *)hw->colPort)->IDR;
+	DMA2_Stream1->M0AR = (uint32_t)hw->frame;
+	DMA2_Stream1->NDTR = hw->rown;
+	DMA2_Stream1->FCR = 0;
+	DMA2_Stream1->CR = DMA_SxCR_CHSEL_2 | DMA_SxCR_CHSEL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_EN;
+
+	/* each period strobes a row on the update and samples the columns on the compare of the channel 1, in the middle of the strobe */
+	clock = HAL_RCC_GetPCLK2Freq();
+	if(RCC->CFGR & RCC_CFGR_PPRE2_2) { /* the timers of a divided APB2 run at twice its clock */
+		clock *= 2;
+	}
+	TIM1->PSC = clock / 1000000 - 1; /* counts microseconds */
+	TIM1->ARR = hw->rowTime - 1;
+	TIM1->CCR1 = hw->rowTime / 2;
+	TIM1->RCR = 0;
+	TIM1->CNT = 0;
+	TIM1->EGR = TIM_EGR_UG; /* loads the prescaler. The DMA requests are still disabled, so no row is strobed */
+	TIM1->SR = 0;
+	TIM1->DIER = TIM_DIER_UDE | TIM_DIER_CC1DE;
+	TIM1->CR1 = TIM_CR1_CEN; /* the first compare samples the row 0 */
+}
+
+static void MatrixKeypad_hardwareReadFrame (void *context, MatrixKeypad_cols_t *frame){
+
+	MatrixKeypad_hardware_t *hw = (MatrixKeypad_hardware_t *)context;
+	MatrixKeypad_cols_t cols;
+	uint32_t value;
+	uint8_t row, col;
+
+	for(row = 0; row < hw->rown; row++){
+		value = ~hw->frame[row]; /* a pressed key reads LOW */
+		cols = 0;
+		for(col = 0; col < hw->coln; col++){
+			cols |= (MatrixKeypad_cols_t)((value >> hw->colBits[col]) & 1) << col;
+		}
+		frame[row] = cols;
+	}
+}
+
+/* Resolves the pins to their ports and builds the row strobes. Returns 0 if the pins aren't on two ports or the hardware is in use */
+static uint8_t MatrixKeypad_hardwareClaim (MatrixKeypad_hardware_t *hw){
+
+	GPIO_TypeDef *rowPort = digitalPinToPort(hw->rowPins[0]), *colPort = digitalPinToPort(hw->colPins[0]);
+	uint32_t rowBits = 0, bit;
+	uint8_t i;
+
+	if(rowPort == NULL || colPort == NULL || (MatrixKeypad_hardwareOwner != NULL && MatrixKeypad_hardwareOwner != hw)) {
+		return 0;
+	}
+
+	for(i = 0; i < hw->rown; i++){
+		if(digitalPinToPort(hw->rowPins[i]) != rowPort) {
+			return 0;
+		}
+		rowBits |= digitalPinToBitMask(hw->rowPins[i]);
+	}
+	for(i = 0; i < hw->rown; i++){
+		bit = digitalPinToBitMask(hw->rowPins[(i + 1) % hw->rown]);
+		hw->strobe[i] = (rowBits & ~bit) | (bit << 16); /* releases the other rows (set) and strobes the row (reset) */
+	}
+	for(i = 0; i < hw->coln; i++){
+		if(digitalPinToPort(hw->colPins[i]) != colPort) {
+			return 0;
+		}
+		for(bit = digitalPinToBitMask(hw->colPins[i]), hw->colBits[i] = 0; bit > 1; bit >>= 1){
+			hw->colBits[i]++;
+		}
+	}
+
+	hw->rowPort = rowPort;
+	hw->colPort = colPort;
+	MatrixKeypad_hardwareOwner = hw;
+
+	return 1;
+}
+#endif
+
+MatrixKeypad_transport_t *MatrixKeypad_initHardwareScan (MatrixKeypad_transport_t *transport, MatrixKeypad_hardware_t *hardware, const uint8_t *rowPins, const uint8_t *colPins, uint8_t rown, uint8_t coln, uint16_t rowTime){
+
+#if MATRIXKEYPAD_USE_PIO || MATRIXKEYPAD_USE_STM32_DMA
+	uint8_t i;
+
+	if(transport == NULL || hardware == NULL || rowPins == NULL || colPins == NULL || rown == 0 || rown > MATRIXKEYPAD_MAX_ROWS || coln == 0 || coln > MATRIXKEYPAD_MAX_COLS || rowTime < 2) {
+		return NULL;
+	}
+
+	hardware->rowPins = rowPins;
+	hardware->colPins = colPins;
+	hardware->rown = rown;
+	hardware->coln = coln;
+	hardware->rowTime = rowTime;
+#if MATRIXKEYPAD_USE_PIO
+	for(i = 1; i < rown || i < coln; i++){ /* the state machine strobes consecutive pins and samples consecutive pins */
+		if((i < rown && rowPins[i] != rowPins[0] + i) || (i < coln && colPins[i] != colPins[0] + i)) {
+			return NULL;
+		}
+	}
+	if(rowPins[0] + rown > NUM_BANK0_GPIOS || colPins[0] + coln > NUM_BANK0_GPIOS) {
+		return NULL;
+	}
+	for(hardware->ring = 1; hardware->ring < rown; hardware->ring <<= 1){
+	}
+#else
+	(void)i;
+#endif
+	if(!MatrixKeypad_hardwareClaim(hardware)) {
+		return NULL;
+	}
+
+	transport->begin = MatrixKeypad_hardwareBegin;
+	transport->selectRow = NULL; /* the hardware strobes the rows */
+	transport->releaseRows = NULL;
+	transport->readCols = NULL;
+	transport->probe = NULL;
+	transport->readFrame = MatrixKeypad_hardwareReadFrame;
+	transport->context = hardware;
+	transport->rown = rown;
+	transport->coln = coln;
+
+	return transport;
+#else
+	(void)transport; /* no hardware scan is supported on this core */
+	(void)hardware;
+	(void)rowPins;
+	(void)colPins;
+	(void)rown;
+	(void)coln;
+	(void)rowTime;
+	return NULL;
+#endif
+}
+#endif
@@ -0,0 +1,265 @@
+/*
+	MatrixKeypad - Simple to use c-like Arduino library to interface matrix keypads.
+	Copyright (C) 2021 Victor Henrique Salvi
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+	USA
+*/
+/**
+ * @file MatrixKeypad_transport.h
+ * @version 1.2.0
+ * @author Victor Henrique Salvi
+ *
+ * Transports for the keypads wired through shift registers, I2C port expanders or charlieplexed pins, or scanned by the hardware (MatrixKeypad_initTransport).
+ *
+ * Each backend fills a MatrixKeypad_transport_t that is passed to MatrixKeypad_initTransport. The backend state and the transport are
+ * allocated by the caller and must live while the keypad is used. Each row strobe costs one bus write and each column read one bus read.
+ * Between the frames the rows are parked LOW, so the backends check if any key is pressed with a single read and the empty frames are skipped.
+ *
+ * As an example, consider a 4x4 keypad with the rows on GPA0-GPA3 and the columns on GPB0-GPB3 of a MCP23017 at the address 0x20:
+ *
+@code{.c}
+#include "MatrixKeypad_transport.h"
+
+MatrixKeypad_t keypad;
+MatrixKeypad_mcp23017_t mcp;
+MatrixKeypad_transport_t transport;
+
+void setup() {
+	MatrixKeypad_initMCP23017(&transport, &mcp, 0x20, 0xFF, 4, 4); //no interrupt pin
+	MatrixKeypad_initTransport(&keypad, (char*)keymap, &transport, 4, 4);
+}
+@endcode
+ *
+ * Requires MATRIXKEYPAD_TRANSPORT and the flag of the backend (MATRIXKEYPAD_SHIFT, MATRIXKEYPAD_MCP23017, MATRIXKEYPAD_PCF8574, MATRIXKEYPAD_CHARLIEPLEX or MATRIXKEYPAD_HARDWARE_SCAN).
+ */
+#ifndef MATRIXKEYPAD_TRANSPORT_H
+#define MATRIXKEYPAD_TRANSPORT_H
+
+#include "MatrixKeypad.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#if MATRIXKEYPAD_SHIFT
+/**
+ * structure that holds the state of a shift register keypad.
+ * The rows are driven by a chain of 74HC595 on MOSI and the columns are read by a chain of 74HC165 on MISO. Both chains share SCK.
+ */
+typedef struct {
+	uint8_t latchPin; /**< Pin connected to the RCLK of the 74HC595 chain */
+	uint8_t loadPin; /**< Pin connected to the SH/LD of the 74HC165 chain */
+	uint8_t rown; /**< Number of rows */
+	uint8_t coln; /**< Number of columns */
+} MatrixKeypad_shift_t;
+
+/**
+ * Initializes a transport for a keypad on shift registers.
+ * The row "R" is on the output Q(R % 8) of the 74HC595 number R / 8, counting from the one connected to MOSI.
+ * The column "C" is on the input D(C % 8) of the 74HC165 number C / 8, counting from the one connected to MISO.
+ * The SPI bus is configured by MatrixKeypad_begin.
+ * Requires MATRIXKEYPAD_SHIFT.
+ *
+ * @param transport The transport to be initialized.
+ * @param shift Storage for the state of the backend.
+ * @param latchPin Pin connected to the RCLK of the 74HC595 chain.
+ * @param loadPin Pin connected to the SH/LD of the 74HC165 chain.
+ * @param rown Number of rows. Must be greater than zero.
+ * @param coln Number of columns. Must be greater than zero.
+ * @return The "transport" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_transport_t *MatrixKeypad_initShift (MatrixKeypad_transport_t *transport, MatrixKeypad_shift_t *shift, uint8_t latchPin, uint8_t loadPin, uint8_t rown, uint8_t coln);
+#endif
+
+#if MATRIXKEYPAD_MCP23017
+/**
+ * structure that holds the state of a MCP23017 keypad. The rows are on the port A and the columns on the port B
+ */
+typedef struct {
+	uint8_t address; /**< I2C address of the expander */
+	uint8_t intPin; /**< Pin connected to the INTA or INTB output or 0xFF if it isn't connected */
+	uint8_t rowMask; /**< Bits of the port A used by the rows */
+	uint8_t colMask; /**< Bits of the port B used by the columns */
+} MatrixKeypad_mcp23017_t;
+
+/**
+ * Initializes a transport for a keypad on a MCP23017.
+ * The row "R" is on GPA(R) and the column "C" on GPB(C). The columns use the internal pullups.
+ * If the interrupt output is connected, the expander signals a pressed key and the empty frames don't use the bus.
+ * The expander and the I2C bus are configured by MatrixKeypad_begin.
+ * Requires MATRIXKEYPAD_MCP23017.
+ *
+ * @param transport The transport to be initialized.
+ * @param mcp Storage for the state of the backend.
+ * @param address I2C address of the expander (0x20 to 0x27).
+ * @param intPin Pin connected to the INTA or INTB output or 0xFF if it isn't connected.
+ * @param rown Number of rows. Must be between 1 and 8.
+ * @param coln Number of columns. Must be between 1 and 8.
+ * @return The "transport" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_transport_t *MatrixKeypad_initMCP23017 (MatrixKeypad_transport_t *transport, MatrixKeypad_mcp23017_t *mcp, uint8_t address, uint8_t intPin, uint8_t rown, uint8_t coln);
+#endif
+
+#if MATRIXKEYPAD_PCF8574
+/**
+ * structure that holds the state of a PCF8574 keypad. The rows and the columns share the 8 pins of the expander
+ */
+typedef struct {
+	uint8_t address; /**< I2C address of the expander */
+	uint8_t rown; /**< Number of rows. The columns start after the rows */
+	uint8_t rowMask; /**< Bits of the port used by the rows */
+	uint8_t colMask; /**< Bits of the column word used by the columns */
+} MatrixKeypad_pcf8574_t;
+
+/**
+ * Initializes a transport for a keypad on a PCF8574 or PCF8574A.
+ * The row "R" is on P(R) and the column "C" on P(rown + C). The 4x4 keypad uses all pins.
+ * The I2C bus is configured by MatrixKeypad_begin.
+ * Requires MATRIXKEYPAD_PCF8574.
+ *
+ * @param transport The transport to be initialized.
+ * @param pcf Storage for the state of the backend.
+ * @param address I2C address of the expander (0x20 to 0x27 or 0x38 to 0x3F for the PCF8574A).
+ * @param rown Number of rows. Must be greater than zero.
+ * @param coln Number of columns. Must be greater than zero and rown + coln must be up to 8.
+ * @return The "transport" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_transport_t *MatrixKeypad_initPCF8574 (MatrixKeypad_transport_t *transport, MatrixKeypad_pcf8574_t *pcf, uint8_t address, uint8_t rown, uint8_t coln);
+#endif
+
+#if MATRIXKEYPAD_CHARLIEPLEX
+/**
+ * structure that holds the state of a charlieplexed keypad. Each pin is a row while it is strobed and a column while another pin is strobed.
+ * With the direct port register backend (MATRIXKEYPAD_FAST_IO on AVR) and up to 8 pins on the same port, the direction and pullup changes of a strobe are two register writes
+ */
+typedef struct {
+	const uint8_t *pins; /**< Pins of the keypad. Must live while the keypad is used */
+	uint8_t pinn; /**< Number of pins */
+	uint8_t strobe; /**< Index of the strobed pin or 0xFF if none is strobed */
+#if MATRIXKEYPAD_USE_PORTS
+	volatile uint8_t *modeReg; /**< Direction register (DDRx) of the port of all pins or NULL if they are on different ports */
+	volatile uint8_t *outReg; /**< Output register (PORTx) of the port */
+	volatile uint8_t *inReg; /**< Input register (PINx) of the port */
+	uint8_t mask; /**< Bits of the port used by the pins */
+	uint8_t bits[8]; /**< Bit mask of each pin */
+#endif
+} MatrixKeypad_charlieplex_t;
+
+/**
+ * Initializes a transport for a charlieplexed keypad, where "pinn" pins serve pinn * (pinn - 1) keys.
+ * The key "R,C" connects the pin "pins[R]" to the pin "pins[C]", with a diode whose cathode is on "pins[R]", so it isn't confused with the key "C,R".
+ * The keypad is initialized with "pinn" rows and "pinn" columns (MatrixKeypad_initTransport) and its key mapping has pinn * pinn entries. The entries of the diagonal (R = C) are never read.
+ * The strobed pin is an output driven LOW and the others are inputs with the internal pullups. There is no idle probe, so each frame strobes every pin.
+ * The pins are configured by MatrixKeypad_begin.
+ * Requires MATRIXKEYPAD_CHARLIEPLEX.
+ *
+@code{.c}
+const uint8_t pins[4] = {0, 1, 2, 3}; //12 keys on the port B of an ATtiny85
+const char keymap[4][4] = {{'\0', '1', '2', '3'}, {'4', '\0', '5', '6'}, {'7', '8', '\0', '9'}, {'*', '0', '#', '\0'}};
+
+MatrixKeypad_initCharlieplex(&transport, &charlieplex, pins, 4);
+MatrixKeypad_initTransport(&keypad, (const char*)keymap, &transport, 4, 4);
+@endcode
+ *
+ * @param transport The transport to be initialized.
+ * @param charlieplex Storage for the state of the backend.
+ * @param pins Array of "pinn" pins.
+ * @param pinn Number of pins. Must be between 2 and MATRIXKEYPAD_MAX_COLS.
+ * @return The "transport" parameter or NULL if it couldn't be initialized.
+ * @since 1.2.0
+ */
+MatrixKeypad_transport_t *MatrixKeypad_initCharlieplex (MatrixKeypad_transport_t *transport, MatrixKeypad_charlieplex_t *charlieplex, const uint8_t *pins, uint8_t pinn);
+#endif
+
+#if MATRIXKEYPAD_HARDWARE_SCAN
+#if MATRIXKEYPAD_MAX_ROWS <= 4
+	#define MATRIXKEYPAD_HARDWARE_RING 4 /**< Words of the frame buffer: MATRIXKEYPAD_MAX_ROWS rounded up to a power of 2, because the RP2040 DMA ring wraps at a power of 2 */
+#elif MATRIXKEYPAD_MAX_ROWS <= 8
+	#define MATRIXKEYPAD_HARDWARE_RING 8
+#elif MATRIXKEYPAD_MAX_ROWS <= 16
+	#define MATRIXKEYPAD_HARDWARE_RING 16
+#else
+	#define MATRIXKEYPAD_HARDWARE_RING 32
+#endif
+
+/**
+ * structure that holds the state of a keypad scanned by the hardware.
+ * The buffers are written by the DMA while the keypad is used, so the structure must not be moved or freed before the keypad
+ */
+typedef struct {
+#if MATRIXKEYPAD_USE_PIO
+	volatile uint32_t frame[MATRIXKEYPAD_HARDWARE_RING] __attribute__((aligned(MATRIXKEYPAD_HARDWARE_RING * 4))); /**< GPIO words sampled for each row, written by the DMA. Aligned to its size for the DMA ring */
+	void *pio; /**< PIO block of the state machine (pio0 or pio1) */
+	uint8_t sm; /**< State machine that strobes the rows */
+	uint8_t offset; /**< Address of the program in the instruction memory of the PIO */
+	uint8_t dma; /**< DMA channel that copies the RX FIFO to "frame" */
+	uint8_t ring; /**< Rows strobed in each frame: "rown" rounded up to a power of 2. The extra rows strobe no pin */
+#elif MATRIXKEYPAD_USE_STM32_DMA
+	volatile uint32_t frame[MATRIXKEYPAD_MAX_ROWS]; /**< IDR words sampled for each row, written by the DMA */
+	uint32_t strobe[MATRIXKEYPAD_MAX_ROWS]; /**< BSRR words read by the DMA. The word "R" strobes the row R + 1, because the first row is strobed before the timer starts */
+	void *rowPort; /**< GPIO port of the rows */
+	void *colPort; /**< GPIO port of the columns */
+	uint8_t colBits[MATRIXKEYPAD_MAX_COLS]; /**< Bit of the IDR of each column */
+#endif
+	const uint8_t *rowPins; /**< Pins of the rows */
+	const uint8_t *colPins; /**< Pins of the columns */
+	uint8_t rown; /**< Number of rows */
+	uint8_t coln; /**< Number of columns */
+	uint16_t rowTime; /**< Time in microseconds each row is strobed */
+} MatrixKeypad_hardware_t;
+
+/**
+ * Initializes a transport for a keypad scanned by the hardware, with no CPU time spent on the row strobes and the column reads:
+ * the hardware strobes the rows in a loop and stores one column word for each row in a buffer, and MatrixKeypad_scan only compares the last frame.
+ * The rows are driven LOW one at a time and released (high impedance) otherwise, so two keys pressed on the same column never short two rows.
+ * The columns use the internal pullups. A frame takes "rown" times "rowTime" (RP2040: "rown" rounded up to a power of 2), and each column is sampled
+ * after half of "rowTime", so slow lines have time to settle.
+ * On RP2040, the rows must be consecutive GPIOs (rowPins[R] = rowPins[0] + R), the columns too, and a free state machine of pio0 or pio1 with room for
+ * 10 instructions and a free DMA channel are claimed.
+ * On STM32F4, the rows must be on one port and the columns on one port, in any order. The backend uses the TIM1 and the streams 1 and 5 of the DMA2,
+ * which can't be used by other libraries (analogWrite on the TIM1 pins, for example).
+ * The hardware is started by MatrixKeypad_begin.
+ * Requires MATRIXKEYPAD_HARDWARE_SCAN.
+ *
+@code{.c}
+const uint8_t rowPins[4] = {2, 3, 4, 5}; //GP2 to GP5
+const uint8_t colPins[4] = {6, 7, 8, 9}; //GP6 to GP9
+
+MatrixKeypad_initHardwareScan(&transport, &hardware, rowPins, colPins, 4, 4, 250); //a frame each 1ms
+MatrixKeypad_initTransport(&keypad, (char*)keymap, &transport, 4, 4);
+@endcode
+ *
+ * @param transport The transport to be initialized.
+ * @param hardware Storage for the state of the backend and the DMA buffers.
+ * @param rowPins Array of "rown" row pins.
+ * @param colPins Array of "coln" column pins.
+ * @param rown Number of rows. Must be between 1 and MATRIXKEYPAD_MAX_ROWS.
+ * @param coln Number of columns. Must be between 1 and MATRIXKEYPAD_MAX_COLS.
+ * @param rowTime Time in microseconds each row is strobed. Must be at least 2.
+ * @return The "transport" parameter or NULL if it couldn't be initialized: the pins don't meet the requirements, the hardware is in use or the core has no hardware scan.
+ * @since 1.2.0
+ */
+MatrixKeypad_transport_t *MatrixKeypad_initHardwareScan (MatrixKeypad_transport_t *transport, MatrixKeypad_hardware_t *hardware, const uint8_t *rowPins, const uint8_t *colPins, uint8_t rown, uint8_t coln, uint16_t rowTime);
+#endif
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif